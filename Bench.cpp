@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Constants.h"
+#include "CpuRenderer.h"
+#include "Util.h"
+
+// Renders a fixed set of camera poses at every SCR_DETAIL level, no window and no input.
+// Keep the poses unchanged, or old numbers stop being comparable!
+
+struct BenchPose
+{
+    const char* name;
+    glm::vec3 pos;
+    float yaw;
+    float pitch;
+};
+
+const BenchPose POSES[] = {
+    { "spawn",      glm::vec3(-1.5f, 0.f, -1.5f),  PI / 4.f,       -2.0f * PI },
+    { "close-up",   glm::vec3(-0.9f, 0.1f, -0.9f), PI / 4.f,       0.f },
+    { "silhouette", glm::vec3(-1.5f, 0.8f, -1.5f), PI / 4.f,       0.35f },
+    { "far",        glm::vec3(-4.f, 1.f, -4.f),    PI / 4.f,       0.2f },
+    { "away",       glm::vec3(-1.5f, 0.f, -1.5f),  PI / 4.f + PI,  0.f },
+};
+
+constexpr float BENCH_FOV = 90.0f;
+
+const glm::vec3 BENCH_COLOR(0.592, 0.835, 0.996);
+
+constexpr int MIN_DETAIL = -4;
+constexpr int MAX_DETAIL = 6;
+
+struct BenchOptions
+{
+    int minDetail = MIN_DETAIL;
+    int maxDetail = MAX_DETAIL;
+    int frames = 3; // per pose and detail level
+    unsigned threads = 0;
+    int tileSize = CpuRenderer::DEFAULT_TILE_SIZE;
+    SimdLevel simdLevel = Packet::bestLevel();
+    std::string csv;
+};
+
+bool parseOptions(const int argc, const char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const bool hasValue = i + 1 < argc;
+
+        if (strcmp(argv[i], "--min-detail") == 0 && hasValue)
+            options.minDetail = std::max(MIN_DETAIL, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--max-detail") == 0 && hasValue)
+            options.maxDetail = std::min(MAX_DETAIL, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue)
+            options.frames = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+            options.threads = unsigned(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--tile") == 0 && hasValue)
+            options.tileSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--csv") == 0 && hasValue)
+            options.csv = argv[++i];
+        else if (strcmp(argv[i], "--simd") == 0 && hasValue)
+        {
+            if (!Packet::parseLevel(argv[++i], options.simdLevel))
+            {
+                std::cout << "Unknown SIMD level \"" << argv[i] << "\"!\n";
+                return false;
+            }
+        }
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--min-detail N] [--max-detail N] [--frames N] [--threads N] [--tile N]\n"
+                      << "    [--simd auto|reference|scalar|sse4|avx2|avx512] [--csv frames.csv]\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(const int argc, const char** argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options))
+        return -1;
+
+    FILE* csv = nullptr;
+    if (!options.csv.empty())
+    {
+        csv = fopen(options.csv.c_str(), "w");
+        if (!csv)
+        {
+            std::cout << "Failed to open \"" << options.csv << "\" for writing!\n";
+            return -1;
+        }
+        fprintf(csv, "detail,width,height,pose,frame,ms,rays,de_calls,steps\n");
+    }
+
+    const CpuRenderer renderer(options.threads, options.simdLevel, options.tileSize);
+
+    printf("Fractal4DBench: %u threads, %s kernel, %dpx tiles, %d frames per pose\n\n",
+           renderer.getThreadCount(), Packet::levelName(renderer.getSimdLevel()), renderer.getTileSize(), options.frames);
+    printf("%6s %11s %7s %9s %9s %9s %9s %9s %14s %10s\n",
+           "detail", "resolution", "frames", "p50 ms", "p90 ms", "p99 ms", "max ms", "Mrays/s", "DE evals", "mean steps");
+
+    uint64_t totalRays = 0, totalDeCalls = 0, totalSteps = 0;
+    float totalMilliseconds = 0;
+
+    std::vector<glm::vec3> pixels;
+
+    for (int detail = options.minDetail; detail <= options.maxDetail; detail++)
+    {
+        const glm::ivec2 resolution(detailResolution(detail));
+
+        std::vector<float> frameTimes;
+        uint64_t rays = 0, deCalls = 0, steps = 0;
+        float milliseconds = 0;
+
+        for (const BenchPose& pose : POSES)
+        {
+            const Camera camera = makeCamera(pose.pos, pose.yaw, pose.pitch, BENCH_FOV, glm::vec2(resolution));
+
+            for (int frame = 0; frame < options.frames; frame++)
+            {
+                const RenderStats stats = renderer.render(camera, resolution, BENCH_COLOR, pixels);
+
+                frameTimes.push_back(stats.milliseconds);
+                rays += stats.rays;
+                deCalls += stats.deCalls;
+                steps += stats.steps;
+                milliseconds += stats.milliseconds;
+
+                if (csv)
+                    fprintf(csv, "%d,%d,%d,%s,%d,%f,%llu,%llu,%llu\n", detail, resolution.x, resolution.y, pose.name, frame, stats.milliseconds,
+                            (unsigned long long)stats.rays, (unsigned long long)stats.deCalls, (unsigned long long)stats.steps);
+            }
+        }
+
+        std::sort(frameTimes.begin(), frameTimes.end());
+
+        const std::string res = std::to_string(resolution.x) + "x" + std::to_string(resolution.y);
+        printf("%6d %11s %7zu %9.2f %9.2f %9.2f %9.2f %9.3f %14llu %10.2f\n",
+               detail, res.c_str(), frameTimes.size(),
+               percentile(frameTimes, 50), percentile(frameTimes, 90), percentile(frameTimes, 99), frameTimes.back(),
+               float(rays) / (milliseconds * 1000.f), (unsigned long long)deCalls, float(double(steps) / double(rays)));
+        fflush(stdout);
+
+        totalRays += rays;
+        totalDeCalls += deCalls;
+        totalSteps += steps;
+        totalMilliseconds += milliseconds;
+    }
+
+    printf("\nTotal: %.1f ms, %llu rays (%.3f Mrays/s), %llu DE evals, %.2f mean steps\n",
+           totalMilliseconds, (unsigned long long)totalRays, float(totalRays) / (totalMilliseconds * 1000.f),
+           (unsigned long long)totalDeCalls, float(double(totalSteps) / double(std::max<uint64_t>(1, totalRays))));
+
+    if (csv)
+        fclose(csv);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "BrickMap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include <glm/gtc/packing.hpp>
+
+#include "Packet.h"
+#include "TileScheduler.h"
+
+namespace
+{
+    constexpr int SAMPLES_PER_BRICK = BrickMap::BRICK_SAMPLES * BrickMap::BRICK_SAMPLES * BrickMap::BRICK_SAMPLES;
+    constexpr size_t BRICK_BYTES = SAMPLES_PER_BRICK * sizeof(uint16_t);
+    constexpr int MAX_ATLAS_WIDTH = 2048 / BrickMap::BRICK_SAMPLES; // bricks, the smallest 3D texture size GL allows
+
+    // Bricks per row and column of the atlas. About as many layers as that too, so the last
+    // one, which is allocated whole however few bricks it has, is a small part of the atlas
+    int atlasWidth(const size_t brickCount)
+    {
+        return std::min(std::max(1, int(std::ceil(std::cbrt(double(brickCount))))), MAX_ATLAS_WIDTH);
+    }
+
+    // what upload() allocates for the atlas, every layer of it whole
+    size_t atlasBytes(const size_t brickCount)
+    {
+        const size_t width = size_t(atlasWidth(brickCount));
+        const size_t depth = std::max<size_t>(1, (brickCount + width * width - 1) / (width * width));
+        return width * width * depth * BRICK_BYTES;
+    }
+}
+
+void BrickMap::build(const float radius, int gridSize, const size_t maxBytes, unsigned threadCount)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // An index bigger than half of maxBytes would leave little room for bricks, and one bigger
+    // than all of it none, so the grid gets coarser until it fits
+    gridSize = std::max(1, gridSize);
+    while (gridSize > 1 && sizeof(Header) + size_t(gridSize) * gridSize * gridSize * sizeof(uint32_t) > maxBytes / 2)
+        gridSize /= 2;
+
+    const PacketKernels* kernels = Packet::kernels(Packet::bestLevel());
+
+    const float cellSize = 2.f * radius / float(gridSize);
+    const float voxelSize = cellSize / float(BRICK_CELLS);
+    const float halfDiagonal = cellSize * std::sqrt(3.f) * 0.5f;
+
+    header.origin = glm::vec3(-radius);
+    header.cellSize = cellSize;
+    header.gridSize = gridSize;
+    // an interpolated distance is a blend of the voxel's corners, none of which is more than a
+    // voxel diagonal from where it's sampled (half floats round far less than that)
+    header.margin = voxelSize * std::sqrt(3.f);
+    // closer than this rays run DE, so cached steps are never much shorter than exact ones
+    header.inner = header.margin * 2.f;
+
+    // DE at every cell's centre decides which cells get a brick, one row of cells at a time
+    const size_t cellCount = size_t(gridSize) * gridSize * gridSize;
+    std::vector<float> centerDist(cellCount);
+    {
+        TileScheduler scheduler(glm::ivec2(gridSize, gridSize), 8, threadCount);
+        scheduler.run([&](const Tile& tile, unsigned) {
+            std::vector<float> x(gridSize), y(gridSize), z(gridSize);
+            for (int cz = tile.y; cz < tile.y + tile.height; cz++) {
+                for (int cy = tile.x; cy < tile.x + tile.width; cy++) {
+                    for (int cx = 0; cx < gridSize; cx++) {
+                        x[cx] = header.origin.x + (float(cx) + 0.5f) * cellSize;
+                        y[cx] = header.origin.y + (float(cy) + 0.5f) * cellSize;
+                        z[cx] = header.origin.z + (float(cz) + 0.5f) * cellSize;
+                    }
+                    kernels->de(x.data(), y.data(), z.data(), &centerDist[(size_t(cz) * gridSize + cy) * gridSize], gridSize);
+                }
+            }
+        });
+    }
+
+    std::vector<std::pair<float, uint32_t>> candidates;
+    for (size_t i = 0; i < cellCount; i++) {
+        const int cx = int(i % gridSize);
+        const int cy = int(i / gridSize % gridSize);
+        const int cz = int(i / (size_t(gridSize) * gridSize));
+        const glm::vec3 center = header.origin + (glm::vec3(cx, cy, cz) + 0.5f) * cellSize;
+
+        // outside the bound DE bails out in an iteration or two anyway
+        if (glm::length(center) - halfDiagonal > radius)
+            continue;
+
+        // the whole cell has to be clear of the surface for its brick to be any use
+        if (centerDist[i] - halfDiagonal > header.inner)
+            candidates.emplace_back(centerDist[i], uint32_t(i));
+    }
+    candidateCount = candidates.size();
+
+    // the most bricks whose atlas still fits next to the index
+    const size_t indexBytes = sizeof(Header) + cellCount * sizeof(uint32_t);
+    size_t maxBricks = 0;
+    if (maxBytes >= indexBytes + atlasBytes(0)) {
+        size_t tooMany = std::min(candidates.size(), size_t(MAX_ATLAS_WIDTH) * MAX_ATLAS_WIDTH * MAX_ATLAS_WIDTH) + 1;
+        while (tooMany - maxBricks > 1) {
+            const size_t middle = (maxBricks + tooMany) / 2;
+            if (indexBytes + atlasBytes(middle) <= maxBytes)
+                maxBricks = middle;
+            else
+                tooMany = middle;
+        }
+    }
+
+    // the closer to the surface, the more iterations DE runs, so those bricks save the most
+    if (candidates.size() > maxBricks) {
+        std::nth_element(candidates.begin(), candidates.begin() + maxBricks, candidates.end());
+        candidates.resize(maxBricks);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+
+    cells.assign(cellCount, 0);
+    brickCells.clear();
+    for (const auto& candidate : candidates) {
+        const uint32_t i = candidate.second;
+        cells[i] = uint32_t(brickCells.size() + 1);
+        brickCells.emplace_back(int(i % gridSize), int(i / gridSize % gridSize), int(i / (uint32_t(gridSize) * gridSize)));
+    }
+
+    header.atlasWidth = atlasWidth(brickCells.size());
+
+    // and fill the bricks, a few at a time on every thread
+    samples.assign(brickCells.size() * SAMPLES_PER_BRICK, 0);
+    if (!brickCells.empty()) {
+        TileScheduler scheduler(glm::ivec2(int(brickCells.size()), 1), 16, threadCount);
+        scheduler.run([&](const Tile& tile, unsigned) {
+            std::vector<float> x(SAMPLES_PER_BRICK), y(SAMPLES_PER_BRICK), z(SAMPLES_PER_BRICK), dist(SAMPLES_PER_BRICK);
+            for (int brick = tile.x; brick < tile.x + tile.width; brick++) {
+                const glm::vec3 corner = header.origin + glm::vec3(brickCells[brick]) * cellSize;
+
+                int s = 0;
+                for (int sz = 0; sz < BRICK_SAMPLES; sz++) {
+                    for (int sy = 0; sy < BRICK_SAMPLES; sy++) {
+                        for (int sx = 0; sx < BRICK_SAMPLES; sx++, s++) {
+                            x[s] = corner.x + float(sx) * voxelSize;
+                            y[s] = corner.y + float(sy) * voxelSize;
+                            z[s] = corner.z + float(sz) * voxelSize;
+                        }
+                    }
+                }
+
+                kernels->de(x.data(), y.data(), z.data(), dist.data(), SAMPLES_PER_BRICK);
+
+                uint16_t* out = &samples[size_t(brick) * SAMPLES_PER_BRICK];
+                for (int i = 0; i < SAMPLES_PER_BRICK; i++)
+                    out[i] = glm::packHalf1x16(dist[i]);
+            }
+        });
+    }
+
+    buildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BrickMap::upload(const GLuint textureUnit, const GLuint storageBinding)
+{
+    destroy();
+
+    const int brickCount = int(brickCells.size());
+    const int width = header.atlasWidth;
+    const int depth = std::max(1, (brickCount + width * width - 1) / (width * width));
+
+    glGenTextures(1, &atlas);
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_3D, atlas);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexStorage3D(GL_TEXTURE_3D, 1, GL_R16F, width * BRICK_SAMPLES, width * BRICK_SAMPLES, depth * BRICK_SAMPLES);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int brick = 0; brick < brickCount; brick++) {
+        const glm::ivec3 atlasBrick(brick % width, brick / width % width, brick / (width * width));
+        const glm::ivec3 offset = atlasBrick * BRICK_SAMPLES;
+        glTexSubImage3D(GL_TEXTURE_3D, 0, offset.x, offset.y, offset.z, BRICK_SAMPLES, BRICK_SAMPLES, BRICK_SAMPLES,
+                        GL_RED, GL_HALF_FLOAT, &samples[size_t(brick) * SAMPLES_PER_BRICK]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    const GLsizeiptr indexBytes = GLsizeiptr(sizeof(Header) + cells.size() * sizeof(uint32_t));
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, indexBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Header), &header);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(Header), GLsizeiptr(cells.size() * sizeof(uint32_t)), cells.data());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, storageBinding, indexBuffer);
+
+    gpuBytes = atlasBytes(size_t(brickCount)) + size_t(indexBytes);
+
+    // the GPU has its own copy now
+    std::vector<uint32_t>().swap(cells);
+    std::vector<uint16_t>().swap(samples);
+}
+
+void BrickMap::destroy()
+{
+    glDeleteTextures(1, &atlas);
+    atlas = 0;
+
+    glDeleteBuffers(1, &indexBuffer);
+    indexBuffer = 0;
+
+    gpuBytes = 0;
+}
+
+int BrickMap::getGridSize() const
+{
+    return header.gridSize;
+}
+
+size_t BrickMap::getBrickCount() const
+{
+    return brickCells.size();
+}
+
+size_t BrickMap::getCandidateCount() const
+{
+    return candidateCount;
+}
+
+size_t BrickMap::getBytes() const
+{
+    return gpuBytes;
+}
+
+float BrickMap::getBuildMilliseconds() const
+{
+    return buildMilliseconds;
+}
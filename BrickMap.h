@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Distances to the fractal sampled ahead of time, so rays far from the surface can
+// look them up instead of running DE. The cube around the fractal's bound is split
+// into gridSize^3 cells, and every cell inside the bound that's far enough from the
+// surface gets a brick of BRICK_SAMPLES^3 distances in a 3D texture atlas. An index
+// SSBO says which brick each cell has, if any; rays in cells without one (near the
+// surface, or outside the bound where DE bails out right away) run DE as usual.
+// See marchDE() in res/raytrace.comp.
+class BrickMap
+{
+public:
+    static constexpr int BRICK_CELLS = 8; // voxels per brick side
+    static constexpr int BRICK_SAMPLES = BRICK_CELLS + 1; // neighbouring bricks both store their shared face
+
+    BrickMap() = default;
+
+    BrickMap(const BrickMap&) = delete;
+    BrickMap& operator=(const BrickMap&) = delete;
+
+    // Samples DE on the CPU with threadCount threads (0 uses all of them). The bricks
+    // closest to the surface are kept first if they don't all fit in maxBytes, which
+    // counts both the atlas and the index, and a gridSize whose index takes more than
+    // half of it is halved until it doesn't. Doesn't touch OpenGL
+    void build(float radius, int gridSize, size_t maxBytes, unsigned threadCount);
+
+    // needs a current OpenGL context, frees the CPU copy
+    void upload(GLuint textureUnit, GLuint storageBinding);
+
+    // the destructor leaves the GL objects alone, since the context might be gone by then
+    void destroy();
+
+    int getGridSize() const; // after build() made it fit
+    size_t getBrickCount() const;
+    size_t getCandidateCount() const; // bricks that would have been built without maxBytes
+    size_t getBytes() const; // on the GPU
+    float getBuildMilliseconds() const;
+
+private:
+    // mirrors the BrickIndex block in res/raytrace.comp (std430)
+    struct Header
+    {
+        glm::vec3 origin;
+        float cellSize;
+        int32_t gridSize;
+        int32_t atlasWidth; // bricks per row and column of the atlas
+        float margin;
+        float inner;
+    };
+    static_assert(sizeof(Header) == 32, "BrickIndex header is 32 bytes in std430");
+
+    Header header{};
+    std::vector<uint32_t> cells; // brick index + 1, 0 for none
+    std::vector<uint16_t> samples; // BRICK_SAMPLES^3 half floats per brick, x fastest
+    std::vector<glm::ivec3> brickCells; // which cell each brick is for
+
+    size_t candidateCount = 0;
+    float buildMilliseconds = 0;
+
+    GLuint atlas = 0;
+    GLuint indexBuffer = 0;
+    size_t gpuBytes = 0;
+};
@@ -0,0 +1,194 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Util.h"
+
+namespace
+{
+    constexpr int VALUE_COUNT = 7; // everything in a key but its time
+
+    // the lowest FOV a path can reach, at 0 getRayDir() divides by zero and below it the image flips
+    constexpr float MIN_FOV = 1;
+
+    void toValues(const CameraKey& key, float* values)
+    {
+        values[0] = key.position.x;
+        values[1] = key.position.y;
+        values[2] = key.position.z;
+        values[3] = key.yaw;
+        values[4] = key.pitch;
+        values[5] = key.fov;
+        values[6] = key.w;
+    }
+
+    CameraKey fromValues(const float time, const float* values)
+    {
+        CameraKey key;
+        key.time = time;
+        key.position = glm::vec3(values[0], values[1], values[2]);
+        key.yaw = values[3];
+        key.pitch = values[4];
+        key.fov = values[5];
+        key.w = values[6];
+        return key;
+    }
+}
+
+bool CameraPath::load(const std::string& path)
+{
+    keys.clear();
+    framesPerSecond = 60;
+    formulaSet = false;
+
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "Failed to open camera path \"" << path << "\"!\n";
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream stream(line);
+        std::string first;
+        if (!(stream >> first))
+            continue;
+
+        const auto fail = [&](const char* problem) {
+            std::cout << path << ":" << lineNumber << ": " << problem << "\n";
+            return false;
+        };
+
+        if (first == "formula")
+        {
+            std::string name;
+            if (!(stream >> name) || !Formulas::parse(name.c_str(), formula))
+                return fail("unknown formula");
+            formulaSet = true;
+            continue;
+        }
+
+        if (first == "fps")
+        {
+            if (!(stream >> framesPerSecond) || !(framesPerSecond > 0))
+                return fail("fps must be a positive number");
+            continue;
+        }
+
+        CameraKey key;
+        std::istringstream firstStream(first);
+        if (!(firstStream >> key.time) || !(stream >> key.position.x >> key.position.y >> key.position.z
+                                                   >> key.yaw >> key.pitch >> key.fov >> key.w))
+            return fail("a keyframe is \"time x y z yaw pitch fov w\"");
+
+        if (!keys.empty() && key.time <= keys.back().time)
+            return fail("keyframes must be in order, each later than the last");
+
+        keys.push_back(key);
+    }
+
+    if (keys.empty())
+    {
+        std::cout << "Camera path \"" << path << "\" has no keyframes!\n";
+        return false;
+    }
+
+    return true;
+}
+
+CameraKey CameraPath::at(const float seconds) const
+{
+    if (keys.empty())
+        return {};
+
+    const float time = keys.front().time + seconds;
+    if (time <= keys.front().time)
+        return keys.front();
+
+    if (time >= keys.back().time)
+        return keys.back();
+
+    // the segment from key i to i + 1 that time falls in
+    const size_t i = size_t(std::upper_bound(keys.begin(), keys.end(), time,
+                                             [](const float t, const CameraKey& key) { return t < key.time; })
+                            - keys.begin()) - 1;
+
+    const CameraKey& previous = keys[i > 0 ? i - 1 : i];
+    const CameraKey& start = keys[i];
+    const CameraKey& end = keys[i + 1];
+    const CameraKey& next = keys[i + 2 < keys.size() ? i + 2 : i + 1];
+
+    float p0[VALUE_COUNT], p1[VALUE_COUNT], p2[VALUE_COUNT], p3[VALUE_COUNT];
+    toValues(previous, p0);
+    toValues(start, p1);
+    toValues(end, p2);
+    toValues(next, p3);
+
+    // Cubic Hermite between start and end, with Catmull-Rom tangents that take the uneven
+    // spacing of the keys into account. At the ends of the path the missing neighbour is the
+    // end key itself, which makes the tangent a one sided difference
+    const float span = end.time - start.time;
+    const float startSpan = end.time - previous.time;
+    const float endSpan = next.time - start.time;
+
+    const float t = (time - start.time) / span;
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    const float h00 = 2 * t3 - 3 * t2 + 1;
+    const float h10 = t3 - 2 * t2 + t;
+    const float h01 = -2 * t3 + 3 * t2;
+    const float h11 = t3 - t2;
+
+    float values[VALUE_COUNT];
+    for (int v = 0; v < VALUE_COUNT; v++)
+    {
+        // tangents per second, scaled to the segment
+        const float startTangent = (p2[v] - p0[v]) / startSpan * span;
+        const float endTangent = (p3[v] - p1[v]) / endSpan * span;
+
+        values[v] = h00 * p1[v] + h10 * startTangent + h01 * p2[v] + h11 * endTangent;
+    }
+
+    // The spline overshoots keys next to a sharp change. Past straight up or down the view
+    // flips over, so pitch stops where the mouse does, and FOV stays above 0
+    CameraKey key = fromValues(time, values);
+    key.pitch = clamp(key.pitch, -PI / 2.0f, PI / 2.0f);
+    key.fov = std::max(key.fov, MIN_FOV);
+    return key;
+}
+
+float CameraPath::getDuration() const
+{
+    return keys.empty() ? 0.f : keys.back().time - keys.front().time;
+}
+
+int CameraPath::getFrameCount() const
+{
+    // a hair of slack so a duration that's a whole number of frames keeps its last one
+    return int(std::floor(getDuration() * framesPerSecond + 1e-3f)) + 1;
+}
+
+float CameraPath::getFramesPerSecond() const
+{
+    return framesPerSecond;
+}
+
+bool CameraPath::hasFormula() const
+{
+    return formulaSet;
+}
+
+Formula CameraPath::getFormula() const
+{
+    return formula;
+}
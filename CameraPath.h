@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Formula.h"
+
+// Where the camera is at one moment of a --path animation
+struct CameraKey
+{
+    float time = 0; // seconds since the path started
+    glm::vec3 position = glm::vec3(0);
+    float yaw = 0; // radians, not wrapped, so a path can turn all the way around
+    float pitch = 0;
+    float fov = 90;
+    float w = 0; // only for formulas that are cut through at W
+};
+
+// A .f4dp file: a text file of keyframes, one per line as
+//     time x y z yaw pitch fov w
+// sorted by time, with # comments and two optional settings for the whole path,
+// "formula NAME" and "fps N". Between keyframes every value follows a Catmull-Rom
+// spline, so the camera eases through each key instead of turning at it.
+class CameraPath
+{
+public:
+    CameraPath() = default;
+
+    // prints what's wrong with the file, if anything
+    bool load(const std::string& path);
+
+    // the camera seconds into the path, held at the first and last keys outside of it
+    CameraKey at(float seconds) const;
+
+    // from the first key to the last, in seconds
+    float getDuration() const;
+
+    // frames it takes at getFramesPerSecond(), both ends included
+    int getFrameCount() const;
+
+    float getFramesPerSecond() const;
+
+    // false if the file didn't pick one
+    bool hasFormula() const;
+    Formula getFormula() const;
+
+private:
+    std::vector<CameraKey> keys;
+    float framesPerSecond = 60;
+    bool formulaSet = false;
+    Formula formula = Formula::Mandelbulb;
+};
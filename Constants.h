@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include "include/glm/vec2.hpp"
 #include "include/glm/vec3.hpp"
 
 // PERFORMANCE OPTIONS
@@ -11,4 +12,64 @@ constexpr int WINDOW_HEIGHT = 960;
 
 constexpr float RENDER_DIST = 800.0f;
 
-// END OF PERFORMANCE OPTIONS
\ No newline at end of file
+// pixels per side of the tiles the cone prepass marches one cone for
+constexpr int CONE_TILE = 8;
+
+// steps of each tile's axis ray the prepass records, rays can't skip further ahead than these cover
+constexpr int CREDIT_STEPS = 32;
+
+// how much of the way to last frame's hit a reprojected ray skips. Lower is safer when the camera moves fast
+constexpr float REPROJECT_FRACTION = 0.9f;
+
+// DE samples that check the part of a reprojected ray it skips for things that came into view
+constexpr int REPROJECT_CHECKS = 4;
+
+// how much further than the DE relaxedMarch() steps, 1 is plain sphere tracing and 2 is the most that can work
+constexpr float RELAXATION = 1.5f;
+
+// cells per side of the brick cache's grid, and how much GPU memory it may use (both can be set with flags)
+constexpr int BRICK_GRID = 64;
+constexpr int BRICK_CACHE_MB = 64;
+
+// how close to the fractal sliceStart lets rays get before they have to march again. Bigger
+// lasts longer as W moves (up to half of this) but skips less
+constexpr float SLICE_EPSILON = 0.02f;
+
+// jittered samples averaged together while the view stays still, after that nothing is raytraced until it moves
+constexpr int ACCUMULATE_SAMPLES = 64;
+
+// side of the tiles --tiled renders and writes one at a time, a multiple of 16 for TIFF.
+// What the GPU needs at once only depends on this, not on the image size
+constexpr int TIFF_TILE = 512;
+
+// fractions of a step the G-buffer keeps, so averaged samples don't round to whole steps.
+// Rays stop after MAX_STEPS + 1, which has to fit in 16 bits at this scale
+constexpr int STEP_SCALE = 256;
+
+// END OF PERFORMANCE OPTIONS
+
+// resolution the FOV is specified at, frustumDiv scales from this
+constexpr glm::vec2 DEFAULT_RES(214, 120);
+
+// FRACTAL OPTIONS (keep in sync with res/raytrace.comp)
+
+constexpr int ITERATIONS = 30;
+constexpr float POWER = 10.0f;
+constexpr float BAILOUT = 2.0f;
+
+// POWER when it's a whole number of at least 2, which lets DE use the triplex form without trig. 0 otherwise
+constexpr int INT_POWER = (POWER >= 2.0f && POWER == float(int(POWER))) ? int(POWER) : 0;
+
+// highest set bit of INT_POWER - 1 and INT_POWER, for raising to them by squaring
+constexpr int highestBit(const int n) { return n > 1 ? 1 + highestBit(n >> 1) : 0; }
+
+// the quaternion Julia set for --formula julia, and how far W swings either way as time goes on
+constexpr float JULIA_C[4] = { -0.2f, 0.6f, 0.2f, 0.2f };
+constexpr float W_RANGE = 0.8f;
+
+constexpr int MAX_STEPS = 100;
+constexpr float HIT_DIST = 0.00001f;
+
+static_assert((MAX_STEPS + 1) * STEP_SCALE <= 0xFFFF, "the G-buffer's steps must fit in 16 bits");
+
+// END OF FRACTAL OPTIONS
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "CpuRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+float RenderStats::mraysPerSecond() const
+{
+    if (milliseconds <= 0)
+        return 0;
+
+    return float(rays) / (milliseconds * 1000.f);
+}
+
+float RenderStats::meanSteps() const
+{
+    if (rays == 0)
+        return 0;
+
+    return float(double(steps) / double(rays));
+}
+
+float RenderStats::minBusyFraction() const
+{
+    float fraction = 1;
+    for (const ThreadTimes& times : threadTimes)
+        fraction = std::min(fraction, times.busyMilliseconds / std::max(1e-6f, times.busyMilliseconds + times.idleMilliseconds));
+
+    return fraction;
+}
+
+float RenderStats::maxBusyFraction() const
+{
+    float fraction = 0;
+    for (const ThreadTimes& times : threadTimes)
+        fraction = std::max(fraction, times.busyMilliseconds / std::max(1e-6f, times.busyMilliseconds + times.idleMilliseconds));
+
+    return fraction;
+}
+
+// rays are marched in batches this wide, a multiple of every SIMD width
+constexpr int PACKET_BATCH = 64;
+
+CpuRenderer::CpuRenderer(const unsigned threadCount, const SimdLevel simdLevel, const int tileSize)
+    : threadCount(threadCount), tileSize(std::max(1, tileSize)), simdLevel(simdLevel)
+{
+    if (this->threadCount == 0)
+        this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    if (!Packet::isSupported(this->simdLevel))
+        this->simdLevel = Packet::bestLevel();
+
+    kernels = Packet::kernels(this->simdLevel);
+}
+
+RenderStats CpuRenderer::render(const Camera& camera, const glm::ivec2& screenSize, const glm::vec3& color, std::vector<glm::vec3>& pixels) const
+{
+    return render(camera, screenSize, glm::ivec2(0), screenSize, color, pixels);
+}
+
+RenderStats CpuRenderer::render(const Camera& camera, const glm::ivec2& screenSize, const glm::ivec2& origin, const glm::ivec2& size,
+                                const glm::vec3& color, std::vector<glm::vec3>& pixels) const
+{
+    pixels.resize(size_t(size.x) * size.y);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // padded so threads don't fight over cache lines
+    struct alignas(64) PaddedCounters
+    {
+        SpanCounters counters;
+    };
+    std::vector<PaddedCounters> threadCounters(threadCount);
+
+    TileScheduler scheduler(size, tileSize, threadCount);
+    scheduler.run([&](const Tile& tile, const unsigned thread) {
+        for (int y = tile.y; y < tile.y + tile.height; y++)
+            renderSpan(camera, screenSize, color, origin.x + tile.x, origin.y + y, tile.width, &pixels[size_t(y) * size.x + tile.x], threadCounters[thread].counters);
+    });
+
+    RenderStats stats;
+    stats.threadTimes = scheduler.getThreadTimes();
+    for (const PaddedCounters& counters : threadCounters) {
+        stats.steps += counters.counters.steps;
+        stats.deCalls += counters.counters.deCalls;
+    }
+    stats.rays = uint64_t(size.x) * size.y;
+    stats.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return stats;
+}
+
+void CpuRenderer::renderSpan(const Camera& camera, const glm::ivec2& screenSize, const glm::vec3& color, const int x, const int y, const int count, glm::vec3* out, SpanCounters& counters) const
+{
+    const glm::vec2 size(screenSize);
+
+    if (!kernels) {
+        // getPixel, plus counting
+        for (int i = 0; i < count; i++) {
+            const glm::vec2 pixelCoords(x + i, y);
+
+            float dist = Fractal::rand(pixelCoords / 100.f) * 1.f;
+            int steps = 0;
+            int deCalls = 0;
+            Fractal::rayMarch(camera.pos, Fractal::rayDir(camera, size, pixelCoords), dist, steps, deCalls);
+
+            out[i] = color * (float(steps) / 40.f);
+            counters.steps += steps;
+            counters.deCalls += deCalls;
+        }
+        return;
+    }
+
+    // same as getPixel, except the marching happens a packet at a time
+    float dirX[PACKET_BATCH], dirY[PACKET_BATCH], dirZ[PACKET_BATCH];
+    float travelDist[PACKET_BATCH];
+    int steps[PACKET_BATCH];
+    int deCalls[PACKET_BATCH];
+
+    for (int start = 0; start < count; start += PACKET_BATCH) {
+        const int batch = std::min(PACKET_BATCH, count - start);
+
+        for (int i = 0; i < batch; i++) {
+            const glm::vec2 pixelCoords(x + start + i, y);
+            const glm::vec3 dir = Fractal::rayDir(camera, size, pixelCoords);
+
+            dirX[i] = dir.x;
+            dirY[i] = dir.y;
+            dirZ[i] = dir.z;
+            travelDist[i] = Fractal::rand(pixelCoords / 100.f) * 1.f;
+        }
+
+        kernels->rayMarch(camera.pos, dirX, dirY, dirZ, travelDist, steps, deCalls, batch);
+
+        for (int i = 0; i < batch; i++) {
+            out[start + i] = color * (float(steps[i]) / 40.f);
+            counters.steps += steps[i];
+            counters.deCalls += deCalls[i];
+        }
+    }
+}
+
+unsigned CpuRenderer::getThreadCount() const
+{
+    return threadCount;
+}
+
+SimdLevel CpuRenderer::getSimdLevel() const
+{
+    return simdLevel;
+}
+
+int CpuRenderer::getTileSize() const
+{
+    return tileSize;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Fractal.h"
+#include "Packet.h"
+#include "TileScheduler.h"
+
+struct RenderStats
+{
+    uint64_t rays = 0;
+    uint64_t steps = 0;
+    uint64_t deCalls = 0;
+    float milliseconds = 0;
+
+    std::vector<ThreadTimes> threadTimes;
+
+    float mraysPerSecond() const;
+
+    float meanSteps() const;
+
+    // fraction of the frame the least and most loaded threads spent working
+    float minBusyFraction() const;
+    float maxBusyFraction() const;
+};
+
+// Runs getPixel from res/raytrace.comp on every core, for machines without OpenGL 4.3
+class CpuRenderer
+{
+public:
+    static constexpr int DEFAULT_TILE_SIZE = 32;
+
+    // threadCount = 0 uses every hardware thread, unsupported SIMD levels fall back to the best supported one
+    explicit CpuRenderer(unsigned threadCount = 0, SimdLevel simdLevel = Packet::bestLevel(), int tileSize = DEFAULT_TILE_SIZE);
+
+    RenderStats render(const Camera& camera, const glm::ivec2& screenSize, const glm::vec3& color, std::vector<glm::vec3>& pixels) const;
+
+    // just the size pixels from origin on of a screenSize image, for tiled renders
+    RenderStats render(const Camera& camera, const glm::ivec2& screenSize, const glm::ivec2& origin, const glm::ivec2& size,
+                       const glm::vec3& color, std::vector<glm::vec3>& pixels) const;
+
+    unsigned getThreadCount() const;
+
+    SimdLevel getSimdLevel() const;
+
+    int getTileSize() const;
+
+private:
+    struct SpanCounters
+    {
+        uint64_t steps = 0;
+        uint64_t deCalls = 0;
+    };
+
+    // renders count pixels starting at (x, y) into out
+    void renderSpan(const Camera& camera, const glm::ivec2& screenSize, const glm::vec3& color, int x, int y, int count, glm::vec3* out, SpanCounters& counters) const;
+
+    unsigned threadCount;
+    int tileSize;
+    SimdLevel simdLevel;
+    const PacketKernels* kernels;
+};
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+// how much of each new sample goes into the smoothed time
+constexpr float SMOOTHING = 0.2f;
+
+DynamicResolution::DynamicResolution(const float targetMilliseconds, const float minScale)
+    : target(std::max(0.f, targetMilliseconds)), minScale(std::clamp(minScale, 0.01f, 1.f))
+{
+}
+
+void DynamicResolution::setTarget(const float targetMilliseconds)
+{
+    target = std::max(0.f, targetMilliseconds);
+    scale = 1.f;
+    smoothed = -1.f;
+    samples = 0;
+    settling = 0;
+}
+
+float DynamicResolution::getTarget() const
+{
+    return target;
+}
+
+bool DynamicResolution::isEnabled() const
+{
+    return target > 0;
+}
+
+bool DynamicResolution::update(const float gpuMilliseconds)
+{
+    if (!isEnabled() || gpuMilliseconds <= 0)
+        return false;
+
+    // still rendered at the old scale
+    if (settling > 0)
+    {
+        settling--;
+        return false;
+    }
+
+    smoothed = smoothed < 0 ? gpuMilliseconds : smoothed + (gpuMilliseconds - smoothed) * SMOOTHING;
+    samples++;
+
+    // one slow frame isn't a reason to change anything
+    if (samples < SETTLE_FRAMES)
+        return false;
+
+    if (smoothed <= target * SLOWER_BAND && smoothed >= target * FASTER_BAND)
+        return false;
+
+    const float step = std::clamp(std::sqrt(target / smoothed), 1.f / MAX_STEP, MAX_STEP);
+    const float newScale = std::clamp(scale * step, minScale, 1.f);
+
+    // already as far as it goes
+    if (std::abs(newScale - scale) < 0.005f)
+        return false;
+
+    scale = newScale;
+    smoothed = -1.f;
+    samples = 0;
+    settling = SETTLE_FRAMES;
+    return true;
+}
+
+float DynamicResolution::getScale() const
+{
+    return scale;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// Picks how much of the detail level's resolution to render so the raytrace stage
+// takes about targetMilliseconds on the GPU. Render time is roughly proportional to
+// the pixel count, so each change scales both sides by sqrt(target / measured), at
+// most MAX_STEP at a time. Nothing changes while the smoothed time stays within a
+// dead band around the target, which is wider on the way up than on the way down
+// so the scale doesn't flip back and forth between two values. After a change it
+// skips SETTLE_FRAMES samples, since GPU times arrive a few frames late and the ones
+// in flight were rendered at the old scale, then smooths SETTLE_FRAMES more before
+// deciding again.
+class DynamicResolution
+{
+public:
+    static constexpr float MAX_STEP = 1.25f;
+    static constexpr float SLOWER_BAND = 1.1f; // scales down above target * SLOWER_BAND
+    static constexpr float FASTER_BAND = 0.8f; // and up below target * FASTER_BAND
+    static constexpr int SETTLE_FRAMES = 8;
+
+    explicit DynamicResolution(float targetMilliseconds = 0, float minScale = 0.25f);
+
+    // 0 turns it off and goes back to full resolution
+    void setTarget(float targetMilliseconds);
+    float getTarget() const;
+    bool isEnabled() const;
+
+    // feed the GPU time of every finished frame, oldest first. Returns true if the scale changed
+    bool update(float gpuMilliseconds);
+
+    // of each side of the detail level's resolution, between minScale and 1
+    float getScale() const;
+
+private:
+    float target;
+    float minScale;
+    float scale = 1.f;
+
+    float smoothed = -1.f; // -1 until the first sample since the last change
+    int samples = 0; // since the last change
+    int settling = 0;
+};
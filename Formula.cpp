@@ -0,0 +1,70 @@
+#include "Formula.h"
+
+#include <cctype>
+#include <sstream>
+
+#include "Constants.h"
+
+namespace
+{
+    const FormulaInfo FORMULAS[FORMULA_COUNT] = {
+        { Formula::Mandelbulb, "mandelbulb", "FORMULA_MANDELBULB", false, true },
+        { Formula::Mandelbox, "mandelbox", "FORMULA_MANDELBOX", false, false },
+        { Formula::Menger, "menger", "FORMULA_MENGER", false, false },
+        { Formula::QuaternionJulia, "julia", "FORMULA_QUATERNION_JULIA", true, false },
+        { Formula::Kifs, "kifs", "FORMULA_KIFS", false, false },
+    };
+
+    bool equalsIgnoringCase(const char* a, const char* b)
+    {
+        for (; *a && *b; a++, b++) {
+            if (std::tolower((unsigned char)*a) != std::tolower((unsigned char)*b))
+                return false;
+        }
+        return *a == *b;
+    }
+}
+
+const FormulaInfo& Formulas::info(const Formula formula)
+{
+    return FORMULAS[int(formula)];
+}
+
+bool Formulas::parse(const char* name, Formula& formula)
+{
+    for (const FormulaInfo& info : FORMULAS) {
+        if (equalsIgnoringCase(name, info.name)) {
+            formula = info.formula;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Formula Formulas::next(const Formula formula)
+{
+    return Formula((int(formula) + 1) % FORMULA_COUNT);
+}
+
+std::string Formulas::names()
+{
+    std::string names;
+    for (const FormulaInfo& info : FORMULAS) {
+        if (!names.empty())
+            names += '|';
+        names += info.name;
+    }
+    return names;
+}
+
+std::string Formulas::defines(const Formula formula)
+{
+    std::stringstream defines;
+    defines << "#define " << info(formula).define << "\n";
+
+    if (formula == Formula::QuaternionJulia)
+        defines << "#define JULIA_C vec4(" << JULIA_C[0] << ", " << JULIA_C[1] << ", " << JULIA_C[2] << ", " << JULIA_C[3] << ")\n";
+
+    return defines.str();
+}
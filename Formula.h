@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+
+// The fractals res/raytrace.comp can draw. Each one is a DE and a bound() behind its
+// own FORMULA_* define, so every formula gets a program of its own with nothing else
+// compiled in.
+enum class Formula
+{
+    Mandelbulb,
+    Mandelbox,
+    Menger,
+    QuaternionJulia,
+    Kifs
+};
+
+constexpr int FORMULA_COUNT = 5;
+
+struct FormulaInfo
+{
+    Formula formula;
+    const char* name; // for --formula and the console
+    const char* define; // tells res/raytrace.comp which DE to build
+    bool usesW; // a 4D formula cut through at W
+    bool hasCpuDE; // Fractal.cpp and the packet kernels have it too, which the CPU renderer and BrickMap need
+};
+
+namespace Formulas
+{
+    const FormulaInfo& info(Formula formula);
+
+    // accepts the names from FormulaInfo, in any case
+    bool parse(const char* name, Formula& formula);
+
+    // the one after it, wrapping around, for flipping through them
+    Formula next(Formula formula);
+
+    // every name, separated by |
+    std::string names();
+
+    // the defines raytrace.comp needs for this formula, on top of the usual ones
+    std::string defines(Formula formula);
+}
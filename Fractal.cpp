@@ -0,0 +1,183 @@
+#include "Fractal.h"
+
+#include <cmath>
+
+#include "Constants.h"
+
+Camera makeCamera(const glm::vec3& pos, const float yaw, const float pitch, const float fov, const glm::vec2& screenSize)
+{
+    Camera camera;
+    camera.pos = pos;
+    camera.cosYaw = cos(yaw);
+    camera.cosPitch = cos(pitch);
+    camera.sinYaw = sin(yaw);
+    camera.sinPitch = sin(pitch);
+    camera.frustumDiv = (screenSize * fov) / DEFAULT_RES;
+
+    return camera;
+}
+
+FrameCamera::FrameCamera(const Camera& camera)
+    : pos(camera.pos), cosYaw(camera.cosYaw), cosPitch(camera.cosPitch), sinYaw(camera.sinYaw), sinPitch(camera.sinPitch), pad0(0),
+      frustumDiv(camera.frustumDiv), pad1{ 0, 0 } {}
+
+FrameUniforms::FrameUniforms(const Camera& camera, const glm::vec2& screenSize, const float time,
+                             const uint32_t flags, const Camera& previousCamera, const uint32_t sampleIndex)
+    : camera(camera), screenSize(screenSize), time(time), flags(flags), sampleIndex(sampleIndex), pad0{}, previousCamera(previousCamera), w(0), pad1(0),
+      tileOrigin(0), imageSize(screenSize), pad2{} {}
+
+glm::vec2 detailResolution(const int detail)
+{
+    return glm::vec2(107 * pow(2, detail), 60 * pow(2, detail));
+}
+
+float Fractal::rand(const glm::vec2& co)
+{
+    const float x = std::sin(glm::dot(co, glm::vec2(12.9898f, 78.233f))) * 43758.5453f;
+    return x - std::floor(x);
+}
+
+float Fractal::genericDE(const glm::vec3& pos)
+{
+    glm::vec3 z = pos;
+    float dr = 1.0f;
+    float r = 0.0f;
+    for (int i = 0; i < ITERATIONS; i++) {
+        r = glm::length(z);
+        if (r > BAILOUT) break;
+
+        // convert to polar coordinates
+        float theta = std::acos(z.z / r);
+        float phi = std::atan2(z.y, z.x);
+        dr = std::pow(r, POWER - 1.0f) * POWER * dr + 1.0f;
+
+        // scale and rotate the point
+        const float zr = std::pow(r, POWER);
+        theta *= POWER;
+        phi *= POWER;
+
+        // convert back to cartesian coordinates
+        z = zr * glm::vec3(std::sin(theta) * std::cos(phi), std::sin(phi) * std::sin(theta), std::cos(theta));
+        z += pos;
+    }
+    return 0.5f * std::log(r) * r / dr;
+}
+
+namespace
+{
+    glm::vec2 complexMul(const glm::vec2& a, const glm::vec2& b)
+    {
+        return glm::vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+    }
+
+    // c^N by squaring, from the highest bit down. N is a constant so this unrolls
+    template<int N>
+    glm::vec2 complexPower(const glm::vec2& c)
+    {
+        glm::vec2 result = c;
+        for (int bit = highestBit(N) - 1; bit >= 0; bit--) {
+            result = complexMul(result, result);
+            if ((N >> bit) & 1)
+                result = complexMul(result, c);
+        }
+        return result;
+    }
+
+    template<int N>
+    float realPower(const float x)
+    {
+        float result = x;
+        for (int bit = highestBit(N) - 1; bit >= 0; bit--) {
+            result *= result;
+            if ((N >> bit) & 1)
+                result *= x;
+        }
+        return result;
+    }
+}
+
+float Fractal::triplexDE(const glm::vec3& pos)
+{
+    glm::vec3 z = pos;
+    float dr = 1.0f;
+    float r = 0.0f;
+    for (int i = 0; i < ITERATIONS; i++) {
+        r = glm::length(z);
+        if (r > BAILOUT) break;
+
+        dr = realPower<INT_POWER - 1>(r) * float(INT_POWER) * dr + 1.0f;
+
+        // r^n * (cos(n * theta), sin(n * theta))
+        const float rho = std::sqrt(z.x * z.x + z.y * z.y);
+        const glm::vec2 thetaN = complexPower<INT_POWER>(glm::vec2(z.z, rho));
+
+        // (cos(n * phi), sin(n * phi)), phi is 0 on the z axis like atan2(0, 0)
+        const glm::vec2 phiN = rho > 0.0f ? complexPower<INT_POWER>(glm::vec2(z.x, z.y) / rho) : glm::vec2(1.0f, 0.0f);
+
+        z = glm::vec3(thetaN.y * phiN.x, thetaN.y * phiN.y, thetaN.x);
+        z += pos;
+    }
+    return 0.5f * std::log(r) * r / dr;
+}
+
+float Fractal::DE(const glm::vec3& pos)
+{
+    return INT_POWER != 0 ? triplexDE(pos) : genericDE(pos);
+}
+
+float Fractal::boundRadius()
+{
+    return std::pow(2.f, 1.f / (POWER - 1.f)) * 1.01f;
+}
+
+bool Fractal::rayMarch(glm::vec3 pos, const glm::vec3& dir, float& travelDist, int& steps, int& deCalls)
+{
+    steps = 0;
+    deCalls = 0;
+
+    while (true) { // march!
+        float dist = DE(pos);
+        deCalls++;
+
+        if (steps == 0)
+            dist *= rand(glm::vec2(dir.x, dir.y));
+
+        if (travelDist > RENDER_DIST)
+            return false;
+
+        if (dist < HIT_DIST)
+            return true;
+
+        pos += dir * dist;
+        travelDist += dist;
+        steps++;
+
+        if (steps > MAX_STEPS)
+            return false;
+    }
+}
+
+glm::vec3 Fractal::rayDir(const Camera& camera, const glm::vec2& screenSize, const glm::vec2& pixelCoords)
+{
+    const glm::vec2 frustumRay = (pixelCoords - (0.5f * screenSize)) / camera.frustumDiv;
+
+    // rotate frustum space to world space
+    const float temp = camera.cosPitch + frustumRay.y * camera.sinPitch;
+
+    return glm::normalize(glm::vec3(frustumRay.x * camera.cosYaw + temp * camera.sinYaw,
+                                    frustumRay.y * camera.cosPitch - camera.sinPitch,
+                                    temp * camera.cosYaw - frustumRay.x * camera.sinYaw));
+}
+
+glm::vec3 Fractal::getPixel(const Camera& camera, const glm::vec2& screenSize, const glm::vec3& color, const glm::vec2& pixelCoords)
+{
+    const glm::vec3 dir = rayDir(camera, screenSize, pixelCoords);
+
+    // raymarch outputs
+    float dist = rand(pixelCoords / 100.f) * 1.f;
+    int steps = 0;
+    int deCalls = 0;
+    rayMarch(camera.pos, dir, dist, steps, deCalls);
+
+    return color * (float(steps) / 40.f);
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Mirrors the Camera struct in res/raytrace.comp
+struct Camera
+{
+    glm::vec3 pos;
+    float cosYaw;
+    float cosPitch;
+    float sinYaw;
+    float sinPitch;
+    glm::vec2 frustumDiv;
+};
+
+// A Camera laid out the way std140 wants it in a uniform block: vec2 on 8 bytes
+// and the whole struct rounded up to 16
+struct FrameCamera
+{
+    glm::vec3 pos;
+    float cosYaw;
+    float cosPitch;
+    float sinYaw;
+    float sinPitch;
+    float pad0;
+    glm::vec2 frustumDiv;
+    float pad1[2];
+
+    FrameCamera() = default;
+    FrameCamera(const Camera& camera);
+};
+
+// Mirrors the Frame uniform block in res/raytrace.comp, padded by hand to std140
+struct FrameUniforms
+{
+    FrameCamera camera;
+
+    glm::vec2 screenSize;
+    float time;
+    uint32_t flags; // FRAME_* bits
+    uint32_t sampleIndex; // how many samples are already averaged into the G-buffer, see ACCUMULATE_SAMPLES
+    float pad0[3];
+
+    FrameCamera previousCamera; // only read with FRAME_REPROJECT
+
+    float w; // the 3D slice of 4D formulas
+    float pad1;
+
+    glm::vec2 tileOrigin; // where the screen sits in the whole image, for tiled renders
+    glm::vec2 imageSize; // screenSize unless tiled
+    float pad2[2];
+
+    FrameUniforms() = default;
+    FrameUniforms(const Camera& camera, const glm::vec2& screenSize, float time,
+                  uint32_t flags = 0, const Camera& previousCamera = Camera(), uint32_t sampleIndex = 0);
+};
+
+// FrameUniforms::flags, passed to the shader as defines
+constexpr uint32_t FRAME_CONE_PREPASS = 1 << 0; // start rays where the cone prepass says
+constexpr uint32_t FRAME_REPROJECT = 1 << 1; // and further if last frame's hits say so. Needs FRAME_CONE_PREPASS
+constexpr uint32_t FRAME_RELAXED_MARCH = 1 << 2; // march with relaxedMarch() instead of rayMarch()
+constexpr uint32_t FRAME_BOUND = 1 << 3; // don't march rays that miss the formula's bound(). Needs FRAME_CONE_PREPASS
+constexpr uint32_t FRAME_BRICK_CACHE = 1 << 4; // look distances up in the BrickMap where it has them
+constexpr uint32_t FRAME_SLICE_RECORD = 1 << 5; // remember how far rays got clear of the fractal at this W
+constexpr uint32_t FRAME_SLICE_REUSE = 1 << 6; // and start from there while W stays close. Needs FRAME_CONE_PREPASS
+
+static_assert(sizeof(FrameCamera) == 48, "FrameCamera must match the std140 layout of Camera");
+static_assert(offsetof(FrameUniforms, screenSize) == 48, "FrameUniforms must match the std140 layout of Frame");
+static_assert(offsetof(FrameUniforms, sampleIndex) == 64, "FrameUniforms must match the std140 layout of Frame");
+static_assert(offsetof(FrameUniforms, previousCamera) == 80, "FrameUniforms must match the std140 layout of Frame");
+static_assert(offsetof(FrameUniforms, w) == 128, "FrameUniforms must match the std140 layout of Frame");
+static_assert(offsetof(FrameUniforms, tileOrigin) == 136, "FrameUniforms must match the std140 layout of Frame");
+static_assert(offsetof(FrameUniforms, imageSize) == 144, "FrameUniforms must match the std140 layout of Frame");
+static_assert(sizeof(FrameUniforms) == 160, "FrameUniforms must match the std140 layout of Frame");
+
+Camera makeCamera(const glm::vec3& pos, float yaw, float pitch, float fov, const glm::vec2& screenSize);
+
+// resolution for one of the SCR_DETAIL levels
+glm::vec2 detailResolution(int detail);
+
+// C++ port of the functions in res/raytrace.comp, used by the CPU renderer.
+// Keep these in sync with the shader!
+namespace Fractal
+{
+    float rand(const glm::vec2& co);
+
+    // the Mandelbulb in polar coordinates, works for any POWER
+    float genericDE(const glm::vec3& pos);
+
+    // The same formula multiplied out for a whole number power, with no trig or pow.
+    // In polar form z^n has angles n*theta and n*phi and length r^n, which is
+    // (z + i*length(xy))^n and ((x + i*y) / length(xy))^n in complex numbers.
+    // Only valid when INT_POWER isn't 0, see --validate-power for how far it is from genericDE.
+    float triplexDE(const glm::vec3& pos);
+
+    // triplexDE if POWER is a whole number, genericDE if not
+    float DE(const glm::vec3& pos);
+
+    // radius of the sphere the whole fractal fits in, see bound() in the shader
+    float boundRadius();
+
+    // deCalls counts DE evaluations, which the shader doesn't need to know
+    bool rayMarch(glm::vec3 pos, const glm::vec3& dir, float& travelDist, int& steps, int& deCalls);
+
+    glm::vec3 rayDir(const Camera& camera, const glm::vec2& screenSize, const glm::vec2& pixelCoords);
+
+    glm::vec3 getPixel(const Camera& camera, const glm::vec2& screenSize, const glm::vec3& color, const glm::vec2& pixelCoords);
+}
\ No newline at end of file
@@ -1,14 +1,36 @@
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "include/glad/glad.h"
 #include <GLFW/glfw3.h>
 
+#include "BrickMap.h"
+#include "CameraPath.h"
 #include "Constants.h"
+#include "CpuRenderer.h"
+#include "DynamicResolution.h"
+#include "Formula.h"
+#include "FrameCapture.h"
+#include "FrameTimer.h"
+#include "Headless.h"
+#include "InputRecording.h"
+#include "RenderManifest.h"
 #include "Shader.h"
+#include "ShaderCache.h"
+#include "ShaderReloader.h"
+#include "TiledTiff.h"
+#include "UniformRing.h"
 #include "Util.h"
 
 struct Controller
@@ -19,6 +41,11 @@ struct Controller
     bool jump;
     bool sneak;
 
+    // accumulated by the callbacks until the next frame takes them
+    glm::vec2 look;
+    int scroll;
+    int detail;
+
     glm::vec2 lastMousePos;
 
     bool firstMouse = true;
@@ -34,20 +61,113 @@ struct Controller
 
 Controller controller{};
 
+InputRecorder recorder;
+InputPlayer player;
+
 bool needsResUpdate = true;
 
 int SCR_DETAIL = 3;
 
-constexpr glm::vec2 defaultRes(214, 120);
+glm::vec2 SCR_RES = DEFAULT_RES * float(1 << SCR_DETAIL);
 
-glm::vec2 SCR_RES = defaultRes * float(1 << SCR_DETAIL);
+// the part of the SCR_RES textures actually raytraced, smaller when dynamicResolution says so
+glm::vec2 renderRes = SCR_RES;
+DynamicResolution dynamicResolution;
+
+// for tiled renders, the whole image and where in it the renderRes tile being raytraced is
+glm::vec2 imageRes(0); // 0 when the screen is the whole image
+glm::vec2 tileOrigin(0);
 
 Shader screenShader;
-Shader computeShader;
+
+// raytrace.comp built for one formula
+struct RaytraceShaders
+{
+    Shader compute;
+    Shader prepass; // with CONE_PREPASS
+    Shader reproject; // and with REPROJECT
+    bool requested = false; // built, or being built by shaderReloader
+
+    bool isReady() const { return compute.ID != 0 && prepass.ID != 0 && reproject.ID != 0; }
+};
+RaytraceShaders raytraceShaders[FORMULA_COUNT];
+Formula formula = Formula::Mandelbulb;
+Formula nextFormula = formula; // switched to as soon as its shaders are ready
 GLuint buffer;
 GLuint vao;
 
-GLuint screenTexture;
+// What raytrace.comp writes for screen.frag to color: steps, the orbit trap and the hit
+// distance. Changing how it's colored doesn't need anything raytraced again, and
+// reprojection reads last frame's distances before they're overwritten
+GLuint stepsTexture;
+GLuint trapTexture;
+GLuint distanceTexture;
+constexpr GLuint TRAP_UNIT = 2;
+constexpr GLuint HIT_DISTANCE_UNIT = 3;
+
+// matches PALETTE_* in res/screen.frag
+enum class Palette
+{
+    Steps,
+    Trap,
+    Fog
+};
+constexpr int PALETTE_COUNT = 3;
+const char* const PALETTE_NAMES[PALETTE_COUNT] = { "steps", "trap", "fog" };
+Palette palette = Palette::Steps;
+
+// the G-buffer colored by resolveColor(), for reading back instead of showing
+GLuint colorTexture;
+GLuint colorFramebuffer;
+
+GLuint coneTexture; // one texel per CONE_TILE pixels, see conePrepass() in res/raytrace.comp
+GLuint axisTravelBuffer; // CREDIT_STEPS floats per cone tile
+bool conePrepass = true;
+
+// last frame's distanceTexture moved into this frame's view. See reproject() in res/raytrace.comp
+GLuint reprojectedTexture;
+bool reprojection = false;
+bool historyValid = false; // distanceTexture holds last frame at this resolution
+Camera previousCamera;
+
+// where formulas that use W are cut through
+float sliceW = 0;
+float wTime = 0; // ms of W animation so far
+bool animateW = true;
+
+// how far rays got clear of the fractal in the last frame marched from the start, see sliceStart in res/raytrace.comp
+GLuint sliceTexture;
+bool sliceReuse = true;
+bool sliceAnchorValid = false;
+FrameUniforms sliceAnchor; // what that frame was rendered with
+
+// averaging jittered samples while the view stays still, see ACCUMULATE_SAMPLES
+bool accumulation = true;
+uint32_t sampleIndex = 0;
+FrameUniforms accumulatedView; // what the samples so far were rendered with
+
+ShaderReloader shaderReloader;
+
+// --capture, every frame's renderRes corner of colorTexture
+FrameCapture frameCapture;
+
+// the Frame uniform block in res/raytrace.comp
+UniformRing frameUniforms;
+constexpr GLuint FRAME_BINDING = 0;
+
+FrameTimer frameTimer;
+Shader graphShader;
+GLuint graphTexture;
+std::vector<float> graphData;
+bool showTimings = false;
+bool relaxedMarch = false; // see relaxedMarch() in res/raytrace.comp
+bool boundClip = true; // see bound() in res/raytrace.comp
+
+// see marchDE() in res/raytrace.comp
+BrickMap brickMap;
+bool brickCache = false;
+constexpr GLuint BRICK_ATLAS_UNIT = 1;
+constexpr GLuint BRICK_INDEX_BINDING = 1;
 
 float deltaTime = 16.666f; // 16.66 = 60fps
 
@@ -67,10 +187,14 @@ float moveSpeed = 1.0f;
 
 glm::vec3 worldUp = glm::vec3(0, 1, 0);
 
+glm::vec3 fractalColor = glm::vec3(0.592, 0.835, 0.996);
+
 float sinYaw, sinPitch;
 float cosYaw, cosPitch;
 
-void initTexture(GLuint* texture, const int width, const int height);
+void initGBuffer(int width, int height);
+void initPrepassBuffers(int width, int height);
+void updateRenderResolution();
 
 void updateScreenResolution(GLFWwindow* window)
 {
@@ -79,8 +203,7 @@ void updateScreenResolution(GLFWwindow* window)
     if (SCR_DETAIL > 6)
         SCR_DETAIL = 6;
 
-    SCR_RES.x = 107 * pow(2, SCR_DETAIL);
-    SCR_RES.y = 60 * pow(2, SCR_DETAIL);
+    SCR_RES = detailResolution(SCR_DETAIL);
 
 
     std::string title = "Fractal4D";
@@ -120,8 +243,12 @@ void updateScreenResolution(GLFWwindow* window)
 
     glfwSetWindowTitle(window, title.c_str());
 
-    glDeleteTextures(1, &screenTexture);
-    initTexture(&screenTexture, int(SCR_RES.x), int(SCR_RES.y));
+    initGBuffer(int(SCR_RES.x), int(SCR_RES.y));
+    initPrepassBuffers(int(SCR_RES.x), int(SCR_RES.y));
+
+    renderRes = glm::vec2(0);
+    updateRenderResolution();
+    sampleIndex = 0; // the old samples went with the old texture
 
     needsResUpdate = false;
 }
@@ -132,85 +259,524 @@ void init()
 }
 
 void pollInputs(GLFWwindow* window);
+std::string computeDefines(Formula formula);
+
+// picks renderRes from SCR_RES and dynamicResolution's scale, the textures stay as they are
+void updateRenderResolution()
+{
+    const glm::vec2 newRes = glm::max(glm::round(SCR_RES * dynamicResolution.getScale()), glm::vec2(1));
+    if (newRes == renderRes)
+        return;
+
+    renderRes = newRes;
+    historyValid = false; // last frame's hits are for the old size
+}
+
+// whether the samples already in the screen texture can be averaged with one rendered from view
+bool sameView(const FrameUniforms& a, const FrameUniforms& b)
+{
+    // these only change where rays start, not what they hit
+    constexpr uint32_t ignoredFlags = FRAME_REPROJECT | FRAME_SLICE_RECORD | FRAME_SLICE_REUSE;
+
+    return memcmp(&a.camera, &b.camera, sizeof(FrameCamera)) == 0 && a.screenSize == b.screenSize
+        && (a.flags & ~ignoredFlags) == (b.flags & ~ignoredFlags) && a.w == b.w
+        && a.tileOrigin == b.tileOrigin && a.imageSize == b.imageSize;
+}
+
+// moves W along by milliseconds of animation, unless it's paused
+void advanceW(const float milliseconds)
+{
+    if (animateW)
+        wTime += milliseconds;
+    sliceW = W_RANGE * std::sin(wTime / 10000.f);
+}
+
+// starts drawing the formula with the shaders built for it. Nothing from the old
+// one carries over, so all history starts over too
+void switchFormula(const Formula newFormula)
+{
+    formula = nextFormula = newFormula;
+    historyValid = false;
+    sliceAnchorValid = false;
+    sampleIndex = 0;
+
+    std::cout << "Drawing the " << Formulas::info(formula).name << "\n";
+}
+
+// Switches to the formula right away if its shaders are built, or else builds them in the
+// background and keeps drawing the current one until the main loop sees they're ready
+void selectFormula(const Formula newFormula)
+{
+    nextFormula = newFormula;
+
+    RaytraceShaders& shaders = raytraceShaders[int(newFormula)];
+    if (!shaders.requested)
+    {
+        const std::string definesStr = computeDefines(newFormula);
+        shaderReloader.build(shaders.compute, "raytrace", HasExtra::Yes, definesStr);
+        shaderReloader.build(shaders.prepass, "raytrace", HasExtra::Yes, "#define CONE_PREPASS\n" + definesStr);
+        shaderReloader.build(shaders.reproject, "raytrace", HasExtra::Yes, "#define REPROJECT\n" + definesStr);
+        shaders.requested = true;
+    }
+
+    if (shaders.isReady())
+        switchFormula(newFormula);
+    else
+        std::cout << "Building the " << Formulas::info(newFormula).name << " shaders, drawing the "
+                  << Formulas::info(formula).name << " until they're done\n";
+}
+
+// runs raytrace.comp over the renderRes corner of the screen texture, unless
+// the view hasn't changed in ACCUMULATE_SAMPLES frames
+void dispatchRaytrace(const float frameTime)
+{
+    const glm::vec2 fullRes = imageRes.x > 0 ? imageRes : renderRes;
+    frustumDiv = (fullRes * FOV) / DEFAULT_RES;
+
+    const Camera camera{ cameraPos, cosYaw, cosPitch, sinYaw, sinPitch, frustumDiv };
+
+    uint32_t flags = 0;
+    if (conePrepass)
+        flags |= FRAME_CONE_PREPASS;
+    if (conePrepass && reprojection && historyValid)
+        flags |= FRAME_REPROJECT;
+    if (relaxedMarch)
+        flags |= FRAME_RELAXED_MARCH;
+    if (conePrepass && boundClip)
+        flags |= FRAME_BOUND;
+    if (brickCache && Formulas::info(formula).hasCpuDE)
+        flags |= FRAME_BRICK_CACHE;
+
+    FrameUniforms uniforms(camera, renderRes, frameTime, flags, previousCamera);
+    uniforms.w = Formulas::info(formula).usesW ? sliceW : 0.f;
+    uniforms.tileOrigin = tileOrigin;
+    uniforms.imageSize = fullRes;
+
+    if (accumulation && sampleIndex > 0 && sameView(uniforms, accumulatedView))
+    {
+        // converged, the image can't get any better
+        if (sampleIndex >= uint32_t(ACCUMULATE_SAMPLES))
+            return;
+        uniforms.sampleIndex = sampleIndex;
+    }
+    else
+        sampleIndex = 0;
+
+    accumulatedView = uniforms;
+    sampleIndex++;
+
+    // Only plain marching records how far rays got clear, and jittered samples aren't the rays it
+    // recorded. The anchor frame is reused until W or anything else about the view moves on
+    if (Formulas::info(formula).usesW && sliceReuse && conePrepass && !relaxedMarch && uniforms.sampleIndex == 0)
+    {
+        FrameUniforms anchor = sliceAnchor;
+        anchor.w = uniforms.w; // W only has to be close
+
+        if (sliceAnchorValid && sameView(uniforms, anchor) && std::abs(uniforms.w - sliceAnchor.w) <= SLICE_EPSILON * 0.5f)
+            uniforms.flags |= FRAME_SLICE_REUSE;
+        else
+        {
+            uniforms.flags |= FRAME_SLICE_RECORD;
+            sliceAnchor = uniforms;
+            sliceAnchorValid = true;
+        }
+    }
+
+    frameUniforms.write(&uniforms, FRAME_BINDING);
+
+    const auto groups = [](const float pixels) { return GLuint((pixels + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE); };
+
+    const RaytraceShaders& shaders = raytraceShaders[int(formula)];
+
+    if (flags & FRAME_CONE_PREPASS)
+    {
+        shaders.prepass.use();
+        glDispatchCompute(groups(std::ceil(renderRes.x / CONE_TILE)), groups(std::ceil(renderRes.y / CONE_TILE)), 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    if (flags & FRAME_REPROJECT)
+    {
+        shaders.reproject.use();
+        glDispatchCompute(groups(renderRes.x), groups(renderRes.y), 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    shaders.compute.use();
+
+    if (uniforms.sampleIndex == 0)
+    {
+        glInvalidateTexImage(stepsTexture, 0);
+        glInvalidateTexImage(trapTexture, 0);
+        glInvalidateTexImage(distanceTexture, 0);
+    }
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    glDispatchCompute(groups(renderRes.x), groups(renderRes.y), 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glUseProgram(0);
+
+    frameUniforms.fence();
+
+    previousCamera = camera;
+    historyValid = true;
+}
+
+void updateCameraAngles()
+{
+    cosYaw = cos(cameraYaw);
+    cosPitch = cos(cameraPitch);
+    sinYaw = sin(cameraYaw);
+    sinPitch = sin(cameraPitch);
+}
+
+// snapshot of the controller for this frame, clears what the callbacks accumulated
+InputFrame takeInputs(const float timestamp)
+{
+    InputFrame input;
+    input.timestamp = timestamp;
+    input.look = controller.look;
+    input.forward = int(controller.forward);
+    input.right = int(controller.right);
+    input.jump = controller.jump;
+    input.sneak = controller.sneak;
+    input.scroll = controller.scroll;
+    input.detail = controller.detail;
+
+    controller.look = glm::vec2(0);
+    controller.scroll = 0;
+    controller.detail = 0;
+
+    return input;
+}
+
+InputStart currentStart()
+{
+    InputStart start;
+    start.cameraPos = cameraPos;
+    start.cameraYaw = cameraYaw;
+    start.cameraPitch = cameraPitch;
+    start.moveSpeed = moveSpeed;
+    start.detail = SCR_DETAIL;
+    return start;
+}
+
+void applyStart(const InputStart& start)
+{
+    cameraPos = start.cameraPos;
+    cameraYaw = start.cameraYaw;
+    cameraPitch = start.cameraPitch;
+    moveSpeed = start.moveSpeed;
+    SCR_DETAIL = start.detail;
+    needsResUpdate = true;
+}
+
+// the only place input touches the camera, so live and replayed frames move it the same way
+void applyInputs(const InputFrame& input)
+{
+    cameraYaw += input.look.x / 500.0f;
+    cameraPitch += input.look.y / 500.0f;
+
+    if(fabs(cameraYaw) > PI)
+    {
+        if (cameraYaw > 0)
+            cameraYaw = -PI - (cameraYaw - PI);
+        else
+            cameraYaw = PI + (cameraYaw + PI);
+    }
+    cameraPitch = clamp(cameraPitch, -PI / 2.0f, PI / 2.0f);
+
+    for (int i = 0; i < input.scroll; i++)
+        moveSpeed *= 1.1f;
+    for (int i = 0; i > input.scroll; i--)
+        moveSpeed *= 0.9f;
+
+    if (input.detail != 0) {
+        SCR_DETAIL += input.detail;
+        needsResUpdate = true;
+    }
+
+    updateCameraAngles();
+
+    // """"physics""""
+    const auto forward = float(input.forward);
+    const auto right = float(input.right);
+    cameraPos.x += (sinYaw * forward + cosYaw * right) / 100. * moveSpeed;
+    cameraPos.z += (cosYaw * forward - sinYaw * right) / 100. * moveSpeed;
+
+    cameraPos += (input.jump * -worldUp) / 100.F * moveSpeed;
+    cameraPos += (input.sneak * worldUp) / 100.F * moveSpeed;
+}
+
+// prints the frame times of a replay, and writes them to csvPath if there is one
+void reportReplay(std::vector<float> frameTimes, const std::string& csvPath)
+{
+    if (frameTimes.empty())
+        return;
+
+    if (!csvPath.empty())
+    {
+        FILE* csv = fopen(csvPath.c_str(), "w");
+        if (csv)
+        {
+            fprintf(csv, "frame,ms\n");
+            for (size_t i = 0; i < frameTimes.size(); i++)
+                fprintf(csv, "%zu,%f\n", i, frameTimes[i]);
+            fclose(csv);
+        }
+        else
+            std::cout << "Failed to open \"" << csvPath << "\" for writing!\n";
+    }
+
+    float total = 0;
+    for (const float time : frameTimes)
+        total += time;
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+
+    printf("Replayed %zu frames in %.1f ms: mean %.2f ms, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+           frameTimes.size(), total, total / float(frameTimes.size()),
+           percentile(frameTimes, 50), percentile(frameTimes, 90), percentile(frameTimes, 99), frameTimes.back());
+}
+
+// draws texture over the whole viewport with whatever shader is in use
+void drawQuad(const GLuint texture)
+{
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(2);
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    glDisableVertexAttribArray(2);
+    glDisableVertexAttribArray(0);
+}
+
+// screen.frag with the G-buffer's renderRes corner bound, ready for drawQuad(stepsTexture).
+// readBack keeps raytrace.comp's row order instead of flipping it for the screen
+void useScreenShader(const bool readBack)
+{
+    glActiveTexture(GL_TEXTURE0 + HIT_DISTANCE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, distanceTexture);
+    glActiveTexture(GL_TEXTURE0 + TRAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D, trapTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    screenShader.use();
+    screenShader.setInt("steps", 0);
+    screenShader.setInt("trap", TRAP_UNIT);
+    screenShader.setInt("hitDistance", HIT_DISTANCE_UNIT);
+    screenShader.setFloat("stepScale", float(STEP_SCALE));
+    screenShader.setVec2("usedSize", renderRes);
+    screenShader.setVec3("color", fractalColor);
+    screenShader.setInt("palette", int(palette));
+    screenShader.setBool("readBack", readBack);
+}
+
+// colors the renderRes corner of the G-buffer into colorTexture, for --capture and reading back
+void resolveColor()
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, colorFramebuffer);
+    glViewport(0, 0, GLsizei(renderRes.x), GLsizei(renderRes.y));
+
+    useScreenShader(true);
+    drawQuad(stepsTexture);
+    glUseProgram(0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+// the size corner of colorTexture after resolveColor(), rows in the order raytrace.comp wrote them
+void readColor(const glm::ivec2& size, std::vector<glm::vec3>& pixels)
+{
+    pixels.resize(size_t(size.x) * size.y);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, colorFramebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, size.x, size.y, GL_RGB, GL_FLOAT, pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+// rolling graph of the last FrameTimer::HISTORY frames in the bottom left corner, CPU on top and GPU below
+void drawTimingGraph(GLFWwindow* window)
+{
+    frameTimer.getGraph(graphData);
+    glBindTexture(GL_TEXTURE_2D, graphTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, FrameTimer::HISTORY, 2 * STAGE_COUNT, GL_RED, GL_FLOAT, graphData.data());
+
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+
+    glViewport(0, 0, std::min(width, FrameTimer::HISTORY * 2), std::min(height, 256));
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    graphShader.use();
+    graphShader.setFloat("msScale", 33.333f);
+    drawQuad(graphTexture);
+
+    glDisable(GL_BLEND);
+    glViewport(0, 0, width, height);
+}
+
+void initGraphTexture()
+{
+    glGenTextures(1, &graphTexture);
+    glBindTexture(GL_TEXTURE_2D, graphTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, FrameTimer::HISTORY, 2 * STAGE_COUNT, 0, GL_RED, GL_FLOAT, nullptr);
+}
+
+// starts --capture, if it was asked for. Needs the context
+void openCapture(const std::string& path, const FrameRate frameRate)
+{
+    if (path.empty())
+        return;
+
+    if (frameCapture.open(path, frameRate))
+        std::cout << "Capturing frames to \"" << path << "\"\n";
+}
+
+// waits for the captured frames still in flight and reports how many made it
+void closeCapture()
+{
+    if (!frameCapture.isOpen())
+        return;
+
+    frameCapture.close();
+    std::cout << "Captured " << frameCapture.getWrittenCount() << " frames";
+    if (frameCapture.getDroppedCount() > 0)
+        std::cout << ", dropped " << frameCapture.getDroppedCount() << " (a different size than the first, or the GPU never got to them)";
+    std::cout << "\n";
+}
+
+void run(GLFWwindow* window, const std::string& csvPath) {
+    frameTimer.init();
+    if (!csvPath.empty() && !frameTimer.openCsv(csvPath))
+        std::cout << "Failed to open \"" << csvPath << "\" for writing!\n";
 
-void run(GLFWwindow* window) {
     auto lastUpdateTime = currentTime();
     float lastFrameTime = lastUpdateTime - 16;
+    const float startTime = lastUpdateTime;
+
+    // currentTime() only has millisecond resolution, too coarse to compare replays
+    std::vector<float> replayFrameTimes;
+    int replayedFrames = 0;
+    auto lastReplayFrame = std::chrono::steady_clock::now();
 
     while (!glfwWindowShouldClose(window)) {
-        const float frameTime = currentTime();
+        frameTimer.beginFrame();
+
+        float frameTime = currentTime();
         deltaTime = frameTime - lastFrameTime;
         lastFrameTime = frameTime;
 
-        pollInputs(window);
+        {
+            ScopedStage stage(frameTimer, Stage::Update);
 
-        if (needsResUpdate) {
-            updateScreenResolution(window);
-        }
-    	
-        cosYaw = cos(cameraYaw);
-        cosPitch = cos(cameraPitch);
-        sinYaw = sin(cameraYaw);
-        sinPitch = sin(cameraPitch);
+            if (shaderReloader.update())
+                sampleIndex = 0; // the samples so far are from the old shader
 
-    	// """"physics""""
-        cameraPos.x += (sinYaw * controller.forward + cosYaw * controller.right) / 100. * moveSpeed;
-        cameraPos.z += (cosYaw * controller.forward - sinYaw * controller.right) / 100. * moveSpeed;
+            if (nextFormula != formula && raytraceShaders[int(nextFormula)].isReady())
+                switchFormula(nextFormula);
 
-    	
-        cameraPos += (controller.jump * -worldUp) / 100.F * moveSpeed;
-        cameraPos += (controller.sneak * worldUp) / 100.F * moveSpeed;
+            pollInputs(window);
 
-        // Compute the raytracing!
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            InputFrame input = takeInputs(frameTime - startTime);
+            if (player.isOpen())
+            {
+                const auto now = std::chrono::steady_clock::now();
+                if (replayedFrames > 0)
+                    replayFrameTimes.push_back(std::chrono::duration<float, std::milli>(now - lastReplayFrame).count());
+                lastReplayFrame = now;
 
+                // live input is ignored, and time only depends on the frame number
+                if (!player.next(input))
+                    break;
 
-        frustumDiv = (SCR_RES * FOV) / defaultRes;
+                deltaTime = player.getStart().deltaTime;
+                frameTime = float(replayedFrames) * deltaTime;
+                replayedFrames++;
+            }
+            else if (recorder.isOpen())
+                recorder.record(input);
 
-        computeShader.use();
+            applyInputs(input);
+            advanceW(deltaTime);
 
-        computeShader.setVec2("screenSize", SCR_RES.x, SCR_RES.y);
+            if (needsResUpdate) {
+                updateScreenResolution(window);
+            }
 
-        computeShader.setFloat("camera.cosYaw", cosYaw);
-        computeShader.setFloat("camera.cosPitch", cosPitch);
-        computeShader.setFloat("camera.sinYaw", sinYaw);
-        computeShader.setFloat("camera.sinPitch", sinPitch);
-        computeShader.setVec2("camera.frustumDiv", frustumDiv);
-        computeShader.setVec3("camera.pos", cameraPos);
-        computeShader.setFloat("time", frameTime);
-    	
-        computeShader.setVec3("color", glm::vec3(0.592, 0.835, 0.996));
+            // this frame's GPU times aren't in yet, but this one's are final
+            if (dynamicResolution.update(frameTimer.getFrame(FrameTimer::QUERY_RING + 1).gpu[int(Stage::Raytrace)]))
+                updateRenderResolution();
+        }
 
+        {
+            ScopedStage stage(frameTimer, Stage::Raytrace);
 
-        glInvalidateTexImage(screenTexture, 0);
+            // Compute the raytracing!
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-        glDispatchCompute(GLuint((SCR_RES.x + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE), GLuint((SCR_RES.y + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE), 1);
-        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
-        glUseProgram(0);
+            dispatchRaytrace(frameTime);
+        }
+
+        {
+            ScopedStage stage(frameTimer, Stage::Capture);
+
+            if (frameCapture.isOpen())
+            {
+                resolveColor();
+                frameCapture.capture(colorTexture, glm::ivec2(renderRes));
+            }
+        }
 
-        // render the screen texture
-        screenShader.use();
-        glEnableVertexAttribArray(0);
-        glEnableVertexAttribArray(2);
+        {
+            ScopedStage stage(frameTimer, Stage::Screen);
 
-        glBindTexture(GL_TEXTURE_2D, screenTexture);
-        glBindBuffer(GL_ARRAY_BUFFER, buffer);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+            // color the G-buffer onto the screen
+            useScreenShader(false);
+            drawQuad(stepsTexture);
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+            if (showTimings)
+                drawTimingGraph(window);
 
-        glDisableVertexAttribArray(2);
-        glDisableVertexAttribArray(0);
+            glUseProgram(0);
+        }
+
+        {
+            ScopedStage stage(frameTimer, Stage::Swap);
 
-        glUseProgram(0);
+            glfwSwapBuffers(window);
+        }
 
-        glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    frameTimer.destroy();
+    shaderReloader.destroy();
+    closeCapture();
+    frameUniforms.destroy();
+    brickMap.destroy();
+
+    // --csv went to frameTimer
+    reportReplay(replayFrameTimes, "");
+
+    if (recorder.isOpen())
+        std::cout << "Recorded " << recorder.getFrameCount() << " frames\n";
+    recorder.close();
 
     glfwTerminate();
 }
@@ -233,22 +799,13 @@ void mouse_callback(GLFWwindow*, const double xPosD, const double yPosD)
     controller.lastMousePos.x = xPos;
     controller.lastMousePos.y = yPos;
 
-    cameraYaw += xOffset / 500.0f;
-    cameraPitch += yOffset / 500.0f;
-
-    if(fabs(cameraYaw) > PI)
-    {
-        if (cameraYaw > 0)
-            cameraYaw = -PI - (cameraYaw - PI);
-        else
-            cameraYaw = PI + (cameraYaw + PI);
-    }
-    cameraPitch = clamp(cameraPitch, -PI / 2.0f, PI / 2.0f);
+    controller.look.x += xOffset;
+    controller.look.y += yOffset;
 }
 
 void scroll_callback(GLFWwindow*, double xoffset, double yoffset)
 {
-    moveSpeed *= (yoffset < 0) ? 0.9 : 1.1;
+    controller.scroll += (yoffset < 0) ? -1 : 1;
 }
 
 bool keyDown(GLFWwindow* window, int key)
@@ -302,13 +859,34 @@ void pollInputs(GLFWwindow* window)
 	if (keyDown(window, GLFW_KEY_LEFT_SHIFT))
         controller.sneak = true;
 
-    if (keyPress(window, GLFW_KEY_COMMA)) {
-        SCR_DETAIL--;
-        needsResUpdate = true;
+    if (keyPress(window, GLFW_KEY_COMMA))
+        controller.detail--;
+    if (keyPress(window, GLFW_KEY_PERIOD))
+        controller.detail++;
+
+    // not camera input, so it isn't recorded
+    if (keyPress(window, GLFW_KEY_T))
+        showTimings = !showTimings;
+    if (keyPress(window, GLFW_KEY_P))
+    {
+        animateW = !animateW;
+        if (animateW)
+            std::cout << "Moving through W\n";
+        else
+            std::cout << "Stopped at W = " << sliceW << "\n";
     }
-    if (keyPress(window, GLFW_KEY_PERIOD)) {
-        SCR_DETAIL++;
-        needsResUpdate = true;
+    if (keyPress(window, GLFW_KEY_F))
+        selectFormula(Formulas::next(nextFormula));
+    if (keyPress(window, GLFW_KEY_C))
+    {
+        // only screen.frag changes, the G-buffer and its samples stay
+        palette = Palette((int(palette) + 1) % PALETTE_COUNT);
+        std::cout << "Coloring by " << PALETTE_NAMES[int(palette)] << "\n";
+    }
+    if (keyPress(window, GLFW_KEY_M))
+    {
+        relaxedMarch = !relaxedMarch;
+        std::cout << (relaxedMarch ? "Marching with over-relaxed sphere tracing\n" : "Marching with plain sphere tracing\n");
     }
 
     controller.forward = clamp(controller.forward, -1.0f, 1.0f);
@@ -340,15 +918,74 @@ void initBuffers() {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void initTexture(GLuint* texture, const int width, const int height) {
-    glGenTextures(1, texture);
-    glBindTexture(GL_TEXTURE_2D, *texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+// one image that the compute shaders read and write
+GLuint initImage(const int width, const int height, const GLenum format)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-    glBindImageTexture(0, *texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+    return texture;
+}
+
+// (re)creates the G-buffer and colorTexture. 10 bytes a pixel, where a color image was 16
+void initGBuffer(const int width, const int height)
+{
+    glDeleteTextures(1, &stepsTexture);
+    stepsTexture = initImage(width, height, GL_R16UI);
+    glBindImageTexture(0, stepsTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R16UI);
+
+    glDeleteTextures(1, &trapTexture);
+    trapTexture = initImage(width, height, GL_RG16F);
+    glBindImageTexture(6, trapTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RG16F);
+
+    glDeleteTextures(1, &distanceTexture);
+    distanceTexture = initImage(width, height, GL_R32F);
+    glBindImageTexture(7, distanceTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+
+    // only drawn into when something reads it back
+    glDeleteTextures(1, &colorTexture);
+    colorTexture = initImage(width, height, GL_RGBA32F);
+
+    glDeleteFramebuffers(1, &colorFramebuffer);
+    glGenFramebuffers(1, &colorFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, colorFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// (re)creates everything the prepass and reprojection keep per pixel or per tile
+void initPrepassBuffers(const int width, const int height) {
+    const int tilesX = (width + CONE_TILE - 1) / CONE_TILE;
+    const int tilesY = (height + CONE_TILE - 1) / CONE_TILE;
+
+    glDeleteTextures(1, &coneTexture);
+    coneTexture = initImage(tilesX, tilesY, GL_R32F);
+    glBindImageTexture(1, coneTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+
+    glDeleteBuffers(1, &axisTravelBuffer);
+    glGenBuffers(1, &axisTravelBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, axisTravelBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(tilesX) * tilesY * CREDIT_STEPS * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, axisTravelBuffer);
+
+    // nothing reads or writes it with reprojection off
+    glDeleteTextures(1, &reprojectedTexture);
+    reprojectedTexture = 0;
+    if (reprojection)
+    {
+        reprojectedTexture = initImage(width, height, GL_R32UI);
+        glBindImageTexture(4, reprojectedTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+    }
+
+    glDeleteTextures(1, &sliceTexture);
+    sliceTexture = initImage(width, height, GL_R32F);
+    glBindImageTexture(5, sliceTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+
+    historyValid = false;
+    sliceAnchorValid = false;
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -356,15 +993,920 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
+struct Options
+{
+    bool cpu = false;
+    bool headless = false;
+    int frames = 1;
+    bool validateSimd = false;
+    bool validatePower = false;
+    bool validateResume = false;
+    std::string output = "fractal.ppm";
+    glm::ivec2 resolution = glm::ivec2(detailResolution(SCR_DETAIL));
+    unsigned threads = 0;
+    int tileSize = CpuRenderer::DEFAULT_TILE_SIZE;
+    bool threadStats = false;
+    SimdLevel simdLevel = Packet::bestLevel();
+    std::string record;
+    std::string replay;
+    std::string csv;
+    std::string capture;
+    std::string cameraPath;
+    bool shaderCache = true;
+    bool conePrepass = true;
+    bool reprojection = false;
+    bool relaxedMarch = false;
+    bool boundClip = true;
+    bool brickCache = false;
+    float targetMilliseconds = 0;
+    bool accumulation = true;
+    Formula formula = Formula::Mandelbulb;
+    Palette palette = Palette::Steps;
+    bool sliceReuse = true;
+    bool tiled = false;
+    int tiffTile = TIFF_TILE;
+    int samples = 1;
+    int brickGrid = BRICK_GRID;
+    int brickCacheMegabytes = BRICK_CACHE_MB;
+};
+
+// accepts PALETTE_NAMES
+bool parsePalette(const char* name, Palette& result)
+{
+    for (int i = 0; i < PALETTE_COUNT; i++)
+    {
+        if (strcmp(name, PALETTE_NAMES[i]) == 0)
+        {
+            result = Palette(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseOptions(const int argc, const char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const bool hasValue = i + 1 < argc;
+
+        if (strcmp(argv[i], "--cpu") == 0)
+            options.cpu = true;
+        else if (strcmp(argv[i], "--headless") == 0)
+            options.headless = true;
+        else if (strcmp(argv[i], "--frames") == 0 && hasValue)
+            options.frames = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--output") == 0 && hasValue)
+            options.output = argv[++i];
+        else if (strcmp(argv[i], "--res") == 0 && hasValue)
+        {
+            if (sscanf(argv[++i], "%dx%d", &options.resolution.x, &options.resolution.y) != 2 || options.resolution.x <= 0 || options.resolution.y <= 0)
+            {
+                std::cout << "Resolution must look like 1920x1080, not \"" << argv[i] << "\"!\n";
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        {
+            const int threads = atoi(argv[++i]);
+            if (threads <= 0)
+            {
+                std::cout << "--threads must be a positive number, not \"" << argv[i] << "\"!\n";
+                return false;
+            }
+            options.threads = unsigned(threads);
+        }
+        else if (strcmp(argv[i], "--simd") == 0 && hasValue)
+        {
+            if (!Packet::parseLevel(argv[++i], options.simdLevel))
+            {
+                std::cout << "Unknown SIMD level \"" << argv[i] << "\"!\n";
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--validate-simd") == 0)
+            options.validateSimd = true;
+        else if (strcmp(argv[i], "--validate-power") == 0)
+            options.validatePower = true;
+        else if (strcmp(argv[i], "--validate-resume") == 0)
+            options.validateResume = true;
+        else if (strcmp(argv[i], "--tile") == 0 && hasValue)
+            options.tileSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--thread-stats") == 0)
+            options.threadStats = true;
+        else if (strcmp(argv[i], "--record") == 0 && hasValue)
+            options.record = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && hasValue)
+            options.replay = argv[++i];
+        else if (strcmp(argv[i], "--csv") == 0 && hasValue)
+            options.csv = argv[++i];
+        else if (strcmp(argv[i], "--capture") == 0 && hasValue)
+            options.capture = argv[++i];
+        else if (strcmp(argv[i], "--path") == 0 && hasValue)
+            options.cameraPath = argv[++i];
+        else if (strcmp(argv[i], "--no-shader-cache") == 0)
+            options.shaderCache = false;
+        else if (strcmp(argv[i], "--no-prepass") == 0)
+            options.conePrepass = false;
+        else if (strcmp(argv[i], "--reproject") == 0)
+            options.reprojection = true;
+        else if (strcmp(argv[i], "--relaxed-march") == 0)
+            options.relaxedMarch = true;
+        else if (strcmp(argv[i], "--no-bound") == 0)
+            options.boundClip = false;
+        else if (strcmp(argv[i], "--formula") == 0 && hasValue)
+        {
+            if (!Formulas::parse(argv[++i], options.formula))
+            {
+                std::cout << "Unknown formula \"" << argv[i] << "\"!\n";
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--palette") == 0 && hasValue)
+        {
+            if (!parsePalette(argv[++i], options.palette))
+            {
+                std::cout << "Unknown palette \"" << argv[i] << "\"!\n";
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--no-slice-reuse") == 0)
+            options.sliceReuse = false;
+        else if (strcmp(argv[i], "--no-accumulate") == 0)
+            options.accumulation = false;
+        else if (strcmp(argv[i], "--target-ms") == 0 && hasValue)
+            options.targetMilliseconds = float(atof(argv[++i]));
+        else if (strcmp(argv[i], "--tiled") == 0)
+            options.tiled = true;
+        else if (strcmp(argv[i], "--tiff-tile") == 0 && hasValue)
+            options.tiffTile = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--samples") == 0 && hasValue)
+            options.samples = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--brick-cache") == 0)
+            options.brickCache = true;
+        else if (strcmp(argv[i], "--brick-grid") == 0 && hasValue)
+            options.brickGrid = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--brick-cache-mb") == 0 && hasValue)
+            options.brickCacheMegabytes = std::max(0, atoi(argv[++i]));
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--cpu | --headless] [--output fractal.ppm] [--res WIDTHxHEIGHT] [--frames N]\n"
+                      << "    [--threads N] [--tile N] [--thread-stats] [--simd auto|reference|scalar|sse4|avx2|avx512] [--validate-simd]\n"
+                      << "    [--validate-power] [--validate-resume]\n"
+                      << "    [--record flight.f4di | --replay flight.f4di] [--csv frames.csv] [--capture video.y4m|frames.ppm]\n"
+                      << "    [--no-shader-cache] [--no-prepass] [--reproject] [--relaxed-march] [--no-bound]\n"
+                      << "    [--brick-cache] [--brick-grid N] [--brick-cache-mb N] [--target-ms N]\n"
+                      << "    [--no-accumulate] [--formula " << Formulas::names() << "] [--no-slice-reuse]\n"
+                      << "    [--palette " << PALETTE_NAMES[0] << "|" << PALETTE_NAMES[1] << "|" << PALETTE_NAMES[2] << "]\n"
+                      << "    [--tiled] [--tiff-tile N] [--samples N] [--path camera.f4dp]\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// renders a single frame from the spawn point without touching OpenGL
+int renderCpu(const Options& options)
+{
+    CpuRenderer renderer(options.threads, options.simdLevel, options.tileSize);
+
+    std::cout << "Rendering " << options.resolution.x << "x" << options.resolution.y
+              << " on " << renderer.getThreadCount() << " CPU threads (" << Packet::levelName(renderer.getSimdLevel()) << ")... " << std::flush;
+
+    const Camera camera = makeCamera(cameraPos, cameraYaw, cameraPitch, FOV, glm::vec2(options.resolution));
+
+    std::vector<glm::vec3> pixels;
+    const RenderStats stats = renderer.render(camera, options.resolution, fractalColor, pixels);
+
+    std::cout << "Done!\n";
+    std::cout << "Took " << stats.milliseconds << "ms (" << stats.mraysPerSecond() << " Mrays/s)\n";
+    std::cout << "Threads were busy " << int(stats.minBusyFraction() * 100) << "% to " << int(stats.maxBusyFraction() * 100) << "% of the frame\n";
+
+    if (options.threadStats)
+    {
+        for (size_t i = 0; i < stats.threadTimes.size(); i++)
+        {
+            const ThreadTimes& times = stats.threadTimes[i];
+            std::cout << "  thread " << i << ": busy " << times.busyMilliseconds << "ms, idle " << times.idleMilliseconds << "ms, "
+                      << times.tiles << " tiles (" << times.stolenTiles << " stolen)\n";
+        }
+    }
+
+    std::cout << "Writing \"" << options.output << "\"... ";
+    if (!writePPM(options.output, options.resolution.x, options.resolution.y, pixels))
+    {
+        std::cout << "Failed to write image!\n";
+        return -1;
+    }
+    std::cout << "Done!\n";
+
+    return 0;
+}
+
+// spliced into res/raytrace.comp after the #version line
+std::string computeDefines(const Formula formula)
+{
+    std::stringstream defines;
+    defines << "#define RENDER_DIST " << RENDER_DIST << "\n";
+    defines << "#define CONE_TILE " << CONE_TILE << "\n";
+    defines << "#define CREDIT_STEPS " << CREDIT_STEPS << "\n";
+    defines << "#define REPROJECT_FRACTION " << REPROJECT_FRACTION << "\n";
+    defines << "#define REPROJECT_CHECKS " << REPROJECT_CHECKS << "\n";
+    defines << "#define FRAME_CONE_PREPASS " << FRAME_CONE_PREPASS << "u\n";
+    defines << "#define RELAXATION " << RELAXATION << "\n";
+    if (INT_POWER != 0)
+        defines << "#define INT_POWER " << INT_POWER << "\n";
+    defines << "#define FRAME_REPROJECT " << FRAME_REPROJECT << "u\n";
+    defines << "#define FRAME_RELAXED_MARCH " << FRAME_RELAXED_MARCH << "u\n";
+    defines << "#define FRAME_BOUND " << FRAME_BOUND << "u\n";
+    defines << "#define FRAME_BRICK_CACHE " << FRAME_BRICK_CACHE << "u\n";
+    defines << "#define BRICK_SAMPLES " << BrickMap::BRICK_SAMPLES << "\n";
+    defines << "#define FRAME_SLICE_RECORD " << FRAME_SLICE_RECORD << "u\n";
+    defines << "#define FRAME_SLICE_REUSE " << FRAME_SLICE_REUSE << "u\n";
+    defines << "#define SLICE_EPSILON " << SLICE_EPSILON << "\n";
+    defines << "#define STEP_SCALE " << STEP_SCALE << ".0\n";
+    defines << Formulas::defines(formula);
+
+    defines << "layout(local_size_x = " << WORK_GROUP_SIZE << ", local_size_y = " << WORK_GROUP_SIZE << ") in;";
+
+    return defines.str();
+}
+
+// returns how long it took, in ms
+float buildShaders()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    const std::string definesStr = computeDefines(formula);
+    RaytraceShaders& shaders = raytraceShaders[int(formula)];
+
+    screenShader = Shader("screen", "screen");
+    graphShader = Shader("screen", "graph");
+    shaders.compute = Shader("raytrace", HasExtra::Yes, definesStr.c_str());
+
+    const std::string prepassDefines = "#define CONE_PREPASS\n" + definesStr;
+    shaders.prepass = Shader("raytrace", HasExtra::Yes, prepassDefines.c_str());
+
+    const std::string reprojectDefines = "#define REPROJECT\n" + definesStr;
+    shaders.reproject = Shader("raytrace", HasExtra::Yes, reprojectDefines.c_str());
+
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// fills the brick cache on the CPU and uploads it, if it's turned on
+void initBrickCache(const Options& options)
+{
+    if (!brickCache)
+        return;
+
+    if (!Formulas::info(formula).hasCpuDE)
+    {
+        std::cout << "The brick cache only knows the Mandelbulb, ignoring --brick-cache for --formula " << Formulas::info(formula).name << "\n";
+        brickCache = false;
+        return;
+    }
+
+    std::cout << "Building brick cache... ";
+    brickMap.build(Fractal::boundRadius(), options.brickGrid, size_t(options.brickCacheMegabytes) << 20, options.threads);
+    brickMap.upload(BRICK_ATLAS_UNIT, BRICK_INDEX_BINDING);
+    printf("Done! (%zu of %zu bricks on a %d^3 grid, %.1fMB, %.0fms)\n", brickMap.getBrickCount(), brickMap.getCandidateCount(),
+           brickMap.getGridSize(), brickMap.getBytes() / 1048576.0, brickMap.getBuildMilliseconds());
+}
+
+// an offscreen context, false if there is none
+bool createHeadlessContext(HeadlessContext& context)
+{
+    std::cout << "Creating headless OpenGL context... ";
+    if (!context.create())
+    {
+        std::cout << "Failed! Falling back to the CPU renderer.\n";
+        return false;
+    }
+    std::cout << "Done! (" << context.getBackendName() << ")\n";
+
+    std::cout << "Loading OpenGL functions... ";
+    if (!gladLoadGLLoader(context.getLoader()))
+    {
+        std::cout << "Failed to initialize GLAD! Falling back to the CPU renderer.\n";
+        return false;
+    }
+    std::cout << "Done! (" << glGetString(GL_RENDERER) << ")\n";
+
+    return true;
+}
+
+// renders on the GPU through an offscreen context, no window and no vsync
+int renderHeadless(const Options& options)
+{
+    HeadlessContext context;
+    if (!createHeadlessContext(context))
+        return renderCpu(options);
+
+    frameUniforms.init(sizeof(FrameUniforms), context.getLoader());
+
+    glEnable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(error_callback, nullptr);
+
+    std::cout << "Building shaders... ";
+    const float shaderMilliseconds = buildShaders();
+    std::cout << "Done! (" << shaderMilliseconds << "ms)\n";
+
+    std::cout << "Building render texture... ";
+    SCR_RES = glm::vec2(options.resolution);
+    renderRes = SCR_RES;
+    initBuffers();
+    initGBuffer(options.resolution.x, options.resolution.y);
+    initPrepassBuffers(options.resolution.x, options.resolution.y);
+    std::cout << "Done!\n";
+
+    initBrickCache(options);
+
+    updateCameraAngles();
+
+    // a replay decides the frame count and only writes its last frame
+    const int frameCount = player.isOpen() ? player.getFrameCount() : options.frames;
+    const int outputCount = player.isOpen() ? 1 : frameCount;
+    const float frameDelta = player.isOpen() ? player.getStart().deltaTime : 16.666f;
+
+    std::vector<glm::vec3> pixels(size_t(options.resolution.x) * options.resolution.y);
+    std::vector<float> frameTimes;
+    float totalMilliseconds = 0;
+
+    openCapture(options.capture, player.isOpen() ? FrameRate::fromFrameTime(frameDelta) : FrameRate());
+    float captureMilliseconds = 0;
+
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        // SCR_DETAIL changes in the recording are ignored, --res decides the resolution
+        InputFrame input;
+        if (player.next(input))
+            applyInputs(input);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        // fixed timestep so every run renders the same frames
+        advanceW(frame > 0 ? frameDelta : 0.f);
+        dispatchRaytrace(float(frame) * frameDelta);
+
+        const bool written = frame >= frameCount - outputCount;
+        if (written || frameCapture.isOpen())
+            resolveColor();
+
+        if (frameCapture.isOpen())
+        {
+            const auto captureStart = std::chrono::steady_clock::now();
+            frameCapture.capture(colorTexture, options.resolution);
+            captureMilliseconds += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - captureStart).count();
+        }
+
+        glFinish();
+
+        const float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        totalMilliseconds += milliseconds;
+        frameTimes.push_back(milliseconds);
+
+        if (!written)
+            continue;
+
+        readColor(options.resolution, pixels);
+
+        const std::string fileName = outputCount == 1 ? options.output : frameFileName(options.output, frame + 1);
+        if (!writePPM(fileName, options.resolution.x, options.resolution.y, pixels))
+        {
+            std::cout << "Failed to write \"" << fileName << "\"!\n";
+            return -1;
+        }
+    }
+
+    if (frameCapture.isOpen())
+    {
+        std::cout << "Capture took " << captureMilliseconds / float(frameCount) << "ms per frame\n";
+        closeCapture();
+    }
+
+    if (player.isOpen())
+    {
+        reportReplay(frameTimes, options.csv);
+        return 0;
+    }
+
+    const float rays = float(options.resolution.x) * float(options.resolution.y) * float(frameCount);
+    std::cout << "Rendered " << frameCount << " frame(s) at " << options.resolution.x << "x" << options.resolution.y
+              << ", " << totalMilliseconds / float(frameCount) << "ms per frame (" << rays / (totalMilliseconds * 1000.f) << " Mrays/s)\n";
+
+    return 0;
+}
+
+// Renders every frame of a --path at its frame rate, with time counted in frames so every run
+// renders the same ones. Nothing waits for a frame to finish: each is queued right behind the
+// last and the capture ring reads them back as the GPU gets through them, so the GPU always
+// has the next frame lined up. Written to --capture if there is one, or else numbered --output PPMs
+int renderPath(const Options& options, const CameraPath& path)
+{
+    HeadlessContext context;
+    if (!createHeadlessContext(context))
+    {
+        std::cout << "Camera paths need the GPU!\n";
+        return -1;
+    }
+
+    frameUniforms.init(sizeof(FrameUniforms), context.getLoader());
+
+    glEnable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(error_callback, nullptr);
+
+    std::cout << "Building shaders... ";
+    const float shaderMilliseconds = buildShaders();
+    std::cout << "Done! (" << shaderMilliseconds << "ms)\n";
+
+    SCR_RES = renderRes = glm::vec2(options.resolution);
+    initBuffers();
+    initGBuffer(options.resolution.x, options.resolution.y);
+    initPrepassBuffers(options.resolution.x, options.resolution.y);
+
+    initBrickCache(options);
+
+    const float framesPerSecond = path.getFramesPerSecond();
+    const int frameCount = path.getFrameCount();
+    const bool numbered = options.capture.empty();
+    if (!frameCapture.open(numbered ? options.output : options.capture, FrameRate::perSecond(framesPerSecond), numbered))
+        return -1;
+
+    const int samples = accumulation ? std::min(options.samples, ACCUMULATE_SAMPLES) : 1;
+
+    std::cout << "Rendering " << frameCount << " frames of \"" << options.cameraPath << "\" at " << framesPerSecond
+              << "fps, " << samples << " samples per pixel\n";
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        const CameraKey key = path.at(float(frame) / framesPerSecond);
+        cameraPos = key.position;
+        cameraYaw = key.yaw;
+        cameraPitch = key.pitch;
+        FOV = key.fov;
+        sliceW = key.w;
+        updateCameraAngles();
+
+        const float frameTime = float(frame) * 1000.f / framesPerSecond;
+        for (int sample = 0; sample < samples; sample++)
+            dispatchRaytrace(frameTime);
+
+        resolveColor();
+        frameCapture.capture(colorTexture, options.resolution);
+
+        // hand it to the GPU now instead of whenever the driver's queue fills up
+        glFlush();
+
+        std::cout << "\rFrame " << frame + 1 << " of " << frameCount << std::flush;
+    }
+    std::cout << "\n";
+
+    closeCapture();
+
+    const float totalMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Took " << totalMilliseconds / 1000.f << "s, " << totalMilliseconds / float(frameCount) << "ms per frame\n";
+
+    return frameCapture.getDroppedCount() > 0 ? -1 : 0;
+}
+
+// Renders every tile the manifest doesn't already have with samples, into tiff. A tile only
+// goes in the manifest once its pixels are synced to disk, so a killed render can pick up
+// from there. Returns false if anything couldn't be written
+bool renderTiles(TiledTiff& tiff, RenderManifest& manifest, const int samples,
+                 const std::function<void(const glm::ivec2& tile, std::vector<glm::vec3>& pixels)>& renderTile)
+{
+    const glm::ivec2 tileCount = tiff.getTileCount();
+    std::vector<glm::vec3> pixels;
+
+    for (int y = 0; y < tileCount.y; y++)
+    {
+        for (int x = 0; x < tileCount.x; x++)
+        {
+            if (manifest.getSamples(x, y) >= samples)
+                continue;
+
+            renderTile(glm::ivec2(x, y), pixels);
+
+            if (!tiff.writeTile(x, y, pixels) || !tiff.sync() || !manifest.finish(x, y, samples))
+                return false;
+
+            std::cout << "\rTile " << y * tileCount.x + x + 1 << " of " << tileCount.x * tileCount.y << std::flush;
+        }
+    }
+    std::cout << "\n";
+
+    return true;
+}
+
+// raytraces the image one tile at a time on the GPU, each at options.samples jittered samples
+bool renderTilesGpu(const Options& options, HeadlessContext& context, TiledTiff& tiff, RenderManifest& manifest)
+{
+    frameUniforms.init(sizeof(FrameUniforms), context.getLoader());
+
+    glEnable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(error_callback, nullptr);
+
+    std::cout << "Building shaders... ";
+    const float shaderMilliseconds = buildShaders();
+    std::cout << "Done! (" << shaderMilliseconds << "ms)\n";
+
+    // the screen is one tile, a window onto the whole image
+    const int tileSize = options.tiffTile;
+    SCR_RES = renderRes = glm::vec2(tileSize);
+    // the tile next door isn't last frame
+    reprojection = false;
+
+    imageRes = glm::vec2(options.resolution);
+    initBuffers();
+    initGBuffer(tileSize, tileSize);
+    initPrepassBuffers(tileSize, tileSize);
+
+    initBrickCache(options);
+    updateCameraAngles();
+
+    const int samples = accumulation ? std::min(options.samples, ACCUMULATE_SAMPLES) : 1;
+    if (samples < options.samples)
+        std::cout << "Rendering " << samples << " samples per pixel, not " << options.samples << "\n";
+
+    return renderTiles(tiff, manifest, samples, [&](const glm::ivec2& tile, std::vector<glm::vec3>& pixels) {
+        tileOrigin = glm::vec2(tile * tileSize);
+        for (int sample = 0; sample < samples; sample++)
+            dispatchRaytrace(0.f);
+
+        resolveColor();
+        readColor(glm::ivec2(tileSize), pixels);
+    });
+}
+
+// the same on every CPU core, one sample per pixel
+bool renderTilesCpu(const Options& options, TiledTiff& tiff, RenderManifest& manifest)
+{
+    if (!Formulas::info(formula).hasCpuDE)
+        std::cout << "The CPU renderer only draws the Mandelbulb, ignoring --formula " << Formulas::info(formula).name << "\n";
+    if (palette != Palette::Steps)
+        std::cout << "The CPU renderer only shades by steps, ignoring --palette " << PALETTE_NAMES[int(palette)] << "\n";
+
+    CpuRenderer renderer(options.threads, options.simdLevel, options.tileSize);
+    const Camera camera = makeCamera(cameraPos, cameraYaw, cameraPitch, FOV, glm::vec2(options.resolution));
+
+    const int tileSize = options.tiffTile;
+    return renderTiles(tiff, manifest, 1, [&](const glm::ivec2& tile, std::vector<glm::vec3>& pixels) {
+        renderer.render(camera, options.resolution, tile * tileSize, glm::ivec2(tileSize), fractalColor, pixels);
+    });
+}
+
+// everything that decides what a --tiled render looks like, so a resumed render can tell
+// whether the tiles already on disk belong to it
+std::string tiledRenderHeader(const Options& options, const bool gpu)
+{
+    std::stringstream header;
+    header << std::setprecision(9);
+    header << "Fractal4D tiled render\n";
+    header << "image " << options.resolution.x << "x" << options.resolution.y << " tiles " << options.tiffTile << "\n";
+    header << "renderer " << (gpu ? "gpu" : "cpu") << (gpu && relaxedMarch ? " relaxed" : "") << "\n";
+    header << "formula " << (gpu ? Formulas::info(formula).name : "mandelbulb") << " w " << sliceW << "\n";
+    header << "camera " << cameraPos.x << " " << cameraPos.y << " " << cameraPos.z << " " << cameraYaw << " " << cameraPitch << " " << FOV << "\n";
+    header << "color " << fractalColor.r << " " << fractalColor.g << " " << fractalColor.b
+           << " palette " << (gpu ? PALETTE_NAMES[int(palette)] : "steps") << "\n";
+
+    if (gpu)
+    {
+        // renderTilesGpu() turns reprojection off, and initBrickCache() the cache for formulas without a CPU DE
+        const auto onOff = [](const bool on) { return on ? "on" : "off"; };
+        header << "prepass " << onOff(conePrepass) << " bound " << onOff(boundClip) << " reproject off";
+        if (brickCache && Formulas::info(formula).hasCpuDE)
+            header << " brick-cache " << options.brickGrid << " " << options.brickCacheMegabytes << "MB\n";
+        else
+            header << " brick-cache off\n";
+
+        // a change to what the shaders do is a different image too
+        const auto read = [](const char* path) {
+            std::ifstream file(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        };
+        const std::string sources = read("res/raytrace.comp") + computeDefines(formula) + read("res/screen.vert") + read("res/screen.frag");
+        header << "shaders " << std::hex << std::setw(16) << std::setfill('0') << ShaderCache::hash(sources) << "\n";
+    }
+
+    return header.str();
+}
+
+// --tiled: options.resolution at any size, rendered and written to a tiled TIFF one tile at a
+// time, so memory use only depends on --tiff-tile. Tiles a killed render already finished
+// are kept, see RenderManifest
+int renderTiled(const Options& options)
+{
+    if (options.tiffTile <= 0 || options.tiffTile % 16 != 0)
+    {
+        std::cout << "TIFF tiles must be a multiple of 16 pixels wide, not " << options.tiffTile << "!\n";
+        return -1;
+    }
+
+    HeadlessContext context;
+    const bool gpu = !options.cpu && createHeadlessContext(context);
+    advanceW(0.f);
+
+    const glm::ivec2 tileCount = (options.resolution + options.tiffTile - 1) / options.tiffTile;
+    const int totalTiles = tileCount.x * tileCount.y;
+
+    RenderManifest manifest;
+    const std::string manifestPath = RenderManifest::pathFor(options.output);
+    int finishedTiles = manifest.open(manifestPath, tiledRenderHeader(options, gpu), tileCount);
+    if (!manifest.isOpen())
+        return -1;
+
+    TiledTiff tiff;
+    bool opened = finishedTiles > 0 && tiff.open(options.output, options.resolution, options.tiffTile, true);
+    if (finishedTiles > 0 && !opened)
+    {
+        std::cout << "\"" << options.output << "\" isn't the image \"" << manifestPath << "\" was for, starting over\n";
+        finishedTiles = 0;
+        if (!manifest.restart())
+            return -1;
+    }
+    opened = opened || tiff.open(options.output, options.resolution, options.tiffTile);
+    if (!opened)
+    {
+        std::cout << "Failed to start writing \"" << options.output << "\"!\n";
+        return -1;
+    }
+
+    std::cout << "Rendering " << options.resolution.x << "x" << options.resolution.y << " as " << totalTiles
+              << " tiles of " << options.tiffTile << "x" << options.tiffTile << " into \"" << options.output << "\""
+              << (tiff.isBigTiff() ? " (BigTIFF)" : "") << "\n";
+    if (finishedTiles > 0)
+        std::cout << "Resuming, " << finishedTiles << " of " << totalTiles << " tiles were already done\n";
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const bool rendered = gpu ? renderTilesGpu(options, context, tiff, manifest) : renderTilesCpu(options, tiff, manifest);
+    if (!tiff.close() || !rendered)
+    {
+        std::cout << "Failed to write \"" << options.output << "\"!\n";
+        return -1;
+    }
+
+    // nothing left to resume
+    manifest.remove();
+
+    const float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Done! Took " << seconds << "s\n";
+
+    return 0;
+}
+
+// checks that the SIMD packet kernel matches the scalar one bit for bit
+int validateSimd(const Options& options)
+{
+    const PacketKernels* scalar = Packet::kernels(SimdLevel::Scalar);
+    const PacketKernels* simd = Packet::kernels(options.simdLevel);
+    if (!simd)
+    {
+        std::cout << "SIMD level \"" << Packet::levelName(options.simdLevel) << "\" has no packet kernel on this machine!\n";
+        return -1;
+    }
+
+    std::cout << "Validating " << Packet::levelName(simd->level) << " against scalar...\n";
+
+    // DE at random points around the fractal
+    constexpr int POINT_COUNT = 1 << 16;
+    std::vector<float> x(POINT_COUNT), y(POINT_COUNT), z(POINT_COUNT);
+    std::vector<float> scalarDist(POINT_COUNT), simdDist(POINT_COUNT);
+
+    Random random(1234);
+    for (int i = 0; i < POINT_COUNT; i++)
+    {
+        x[i] = (random.nextFloat() - 0.5f) * 2.f * BAILOUT;
+        y[i] = (random.nextFloat() - 0.5f) * 2.f * BAILOUT;
+        z[i] = (random.nextFloat() - 0.5f) * 2.f * BAILOUT;
+    }
+
+    scalar->de(x.data(), y.data(), z.data(), scalarDist.data(), POINT_COUNT);
+    simd->de(x.data(), y.data(), z.data(), simdDist.data(), POINT_COUNT);
+
+    int deMismatches = 0;
+    for (int i = 0; i < POINT_COUNT; i++)
+        deMismatches += memcmp(&scalarDist[i], &simdDist[i], sizeof(float)) != 0;
+
+    std::cout << "DE: " << deMismatches << " of " << POINT_COUNT << " points differ\n";
+
+    // and a whole frame
+    const Camera camera = makeCamera(cameraPos, cameraYaw, cameraPitch, FOV, glm::vec2(options.resolution));
+
+    std::vector<glm::vec3> scalarPixels, simdPixels;
+    CpuRenderer(options.threads, SimdLevel::Scalar).render(camera, options.resolution, fractalColor, scalarPixels);
+    CpuRenderer(options.threads, simd->level).render(camera, options.resolution, fractalColor, simdPixels);
+
+    int pixelMismatches = 0;
+    for (size_t i = 0; i < scalarPixels.size(); i++)
+        pixelMismatches += memcmp(&scalarPixels[i], &simdPixels[i], sizeof(glm::vec3)) != 0;
+
+    std::cout << "Frame: " << pixelMismatches << " of " << scalarPixels.size() << " pixels differ\n";
+
+    return (deMismatches == 0 && pixelMismatches == 0) ? 0 : -1;
+}
+
+// genericDE in doubles, as close to the real fractal as we can cheaply get
+double referenceDE(const glm::dvec3& pos)
+{
+    glm::dvec3 z = pos;
+    double dr = 1.0;
+    double r = 0.0;
+    for (int i = 0; i < ITERATIONS; i++) {
+        r = glm::length(z);
+        if (r > BAILOUT) break;
+
+        const double theta = std::acos(z.z / r) * POWER;
+        const double phi = std::atan2(z.y, z.x) * POWER;
+        dr = std::pow(r, POWER - 1.0) * POWER * dr + 1.0;
+
+        z = std::pow(r, double(POWER)) * glm::dvec3(std::sin(theta) * std::cos(phi), std::sin(phi) * std::sin(theta), std::cos(theta));
+        z += pos;
+    }
+    return 0.5 * std::log(r) * r / dr;
+}
+
+// how far genericDE and triplexDE are from referenceDE outside the fractal
+int validatePower()
+{
+    if (INT_POWER == 0)
+    {
+        std::cout << "POWER " << POWER << " isn't a whole number, so there's no triplexDE to validate!\n";
+        return -1;
+    }
+
+    std::cout << "Validating triplexDE and genericDE against doubles for POWER " << INT_POWER << "...\n";
+
+    constexpr int POINT_COUNT = 1 << 18;
+    std::vector<float> genericErrors, triplexErrors;
+
+    Random random(1234);
+    for (int i = 0; i < POINT_COUNT; i++)
+    {
+        const glm::vec3 pos = (glm::vec3(random.nextFloat(), random.nextFloat(), random.nextFloat()) - 0.5f) * 3.f;
+
+        // closer than this the orbits get chaotic and neither float version means much
+        const double reference = referenceDE(glm::dvec3(pos));
+        if (!(reference > 1e-4))
+            continue;
+
+        genericErrors.push_back(float(std::abs(Fractal::genericDE(pos) - reference) / reference));
+        triplexErrors.push_back(float(std::abs(Fractal::triplexDE(pos) - reference) / reference));
+    }
+
+    std::sort(genericErrors.begin(), genericErrors.end());
+    std::sort(triplexErrors.begin(), triplexErrors.end());
+
+    std::cout << genericErrors.size() << " points outside the fractal, relative error:\n";
+    for (const float p : { 50.f, 90.f, 99.f, 99.9f })
+        printf("    p%-5g generic %.3g, triplex %.3g\n", p, percentile(genericErrors, p), percentile(triplexErrors, p));
+
+    return 0;
+}
+
+// Writes a small tiled TIFF in one go and again across three runs, the later two reopening
+// it like a resumed --tiled render does, and checks the two files come out the same
+int validateResume()
+{
+    const glm::ivec2 imageSize(100, 70);
+    constexpr int TILE_SIZE = 32;
+    const std::string wholePath = "validate-resume-whole.tif";
+    const std::string resumedPath = "validate-resume-resumed.tif";
+
+    std::cout << "Validating resumed tiled TIFFs...\n";
+
+    std::vector<glm::vec3> pixels(TILE_SIZE * TILE_SIZE);
+    const auto writeTiles = [&](TiledTiff& tiff, const int first, const int last) {
+        const glm::ivec2 tileCount = tiff.getTileCount();
+        for (int i = first; i < last; i++)
+        {
+            Random random(uint64_t(i + 1));
+            for (glm::vec3& pixel : pixels)
+                pixel = glm::vec3(random.nextFloat(), random.nextFloat(), random.nextFloat());
+
+            if (!tiff.writeTile(i % tileCount.x, i / tileCount.x, pixels))
+                return false;
+        }
+        return true;
+    };
+
+    const auto readAll = [](const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+
+    bool ok = true;
+    const auto check = [&](const bool passed, const char* what) {
+        if (!passed)
+            std::cout << "    FAILED: " << what << "\n";
+        ok &= passed;
+    };
+
+    const glm::ivec2 tileCount = (imageSize + TILE_SIZE - 1) / TILE_SIZE;
+    const int tiles = tileCount.x * tileCount.y;
+
+    TiledTiff whole;
+    check(whole.open(wholePath, imageSize, TILE_SIZE) && writeTiles(whole, 0, tiles) && whole.close(),
+          "writing the image in one go");
+
+    TiledTiff resumed;
+    check(resumed.open(resumedPath, imageSize, TILE_SIZE) && writeTiles(resumed, 0, tiles / 3) && resumed.close(),
+          "writing the first third");
+    check(resumed.open(resumedPath, imageSize, TILE_SIZE, true) && writeTiles(resumed, tiles / 3, tiles * 2 / 3)
+              && resumed.close(),
+          "resuming for the second third");
+    check(resumed.open(resumedPath, imageSize, TILE_SIZE, true) && writeTiles(resumed, tiles * 2 / 3, tiles)
+              && resumed.close(),
+          "resuming again for the rest");
+
+    const std::string wholeBytes = readAll(wholePath);
+    const std::string resumedBytes = readAll(resumedPath);
+    check(!wholeBytes.empty() && wholeBytes.size() == resumedBytes.size(), "same file size");
+    check(wholeBytes == resumedBytes, "same bytes");
+
+    check(!resumed.open(resumedPath, imageSize + TILE_SIZE, TILE_SIZE, true), "refusing to resume a bigger image");
+
+    std::remove(wholePath.c_str());
+    std::remove(resumedPath.c_str());
+
+    std::cout << (ok ? "Resumed TIFFs match\n" : "Resumed TIFFs don't match!\n");
+    return ok ? 0 : -1;
+}
+
 int main(const int argc, const char** argv)
 {
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return -1;
+
+    if (options.validateSimd)
+        return validateSimd(options);
+
+    if (options.validatePower)
+        return validatePower();
+
+    if (options.validateResume)
+        return validateResume();
+
+    ShaderCache::setEnabled(options.shaderCache);
+    conePrepass = options.conePrepass;
+    reprojection = options.reprojection;
+    relaxedMarch = options.relaxedMarch;
+    boundClip = options.boundClip;
+    brickCache = options.brickCache;
+    dynamicResolution.setTarget(options.targetMilliseconds);
+    accumulation = options.accumulation;
+    formula = nextFormula = options.formula;
+    palette = options.palette;
+    sliceReuse = options.sliceReuse;
+
+    if (options.cpu && !options.tiled)
+    {
+        if (!Formulas::info(formula).hasCpuDE)
+            std::cout << "The CPU renderer only draws the Mandelbulb, ignoring --formula " << Formulas::info(formula).name << "\n";
+        if (palette != Palette::Steps)
+            std::cout << "The CPU renderer only shades by steps, ignoring --palette " << PALETTE_NAMES[int(palette)] << "\n";
+        return renderCpu(options);
+    }
+
+    if (!options.replay.empty())
+    {
+        if (!player.open(options.replay))
+        {
+            std::cout << "Failed to read input recording \"" << options.replay << "\"!\n";
+            return -1;
+        }
+        applyStart(player.getStart());
+        std::cout << "Replaying " << player.getFrameCount() << " frames from \"" << options.replay << "\"\n";
+    }
+
+    if (!options.cameraPath.empty())
+    {
+        CameraPath path;
+        if (!path.load(options.cameraPath))
+            return -1;
+
+        if (path.hasFormula())
+            formula = nextFormula = path.getFormula();
+        return renderPath(options, path);
+    }
+
+    if (options.tiled)
+        return renderTiled(options);
+
+    if (options.headless)
+        return renderHeadless(options);
+
     std::cout << "Initializing GLFW... ";
 
     if (!glfwInit())
     {
         // Initialization failed
-        std::cout << "Failed to init GLFW!\n";
-        return -1;
+        std::cout << "Failed to init GLFW! Falling back to the CPU renderer.\n";
+        return renderCpu(options);
     }
 
     std::cout << "Done!\n";
@@ -388,8 +1930,9 @@ int main(const int argc, const char** argv)
     if (!window)
     {
         // Window or OpenGL context creation failed
-        std::cout << "Failed to create window!\n";
-        return -1;
+        std::cout << "Failed to create window! Falling back to the CPU renderer.\n";
+        glfwTerminate();
+        return renderCpu(options);
     }
     std::cout << "Done!\n";
 
@@ -401,7 +1944,8 @@ int main(const int argc, const char** argv)
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
     // turn on VSync so we don't run at about a kjghpillion fps
-    glfwSwapInterval(1);
+    // (unless replaying, then we want to know how fast we could go)
+    glfwSwapInterval(player.isOpen() ? 0 : 1);
 
     std::cout << "Loading OpenGL functions... ";
     if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
@@ -411,6 +1955,8 @@ int main(const int argc, const char** argv)
     }
     std::cout << "Done!\n";
 
+    frameUniforms.init(sizeof(FrameUniforms), reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+
     std::cout << "Configuring OpenGL... ";
     glEnable(GL_DEBUG_OUTPUT);
     glDebugMessageCallback(error_callback, nullptr);
@@ -429,17 +1975,8 @@ int main(const int argc, const char** argv)
     std::cout << "Done!\n";
 
     std::cout << "Building shaders... ";
-    std::stringstream defines;
-    defines << "#define RENDER_DIST " << RENDER_DIST << "\n";
-
-    defines << "layout(local_size_x = " << WORK_GROUP_SIZE << ", local_size_y = " << WORK_GROUP_SIZE << ") in;";
-
-    const std::string definesStr = defines.str();
-
-    screenShader = Shader("screen", "screen");
-    computeShader = Shader("raytrace", HasExtra::Yes, definesStr.c_str());
-
-    std::cout << "Done!\n";
+    const float shaderMilliseconds = buildShaders();
+    std::cout << "Done! (" << shaderMilliseconds << "ms)\n";
     
     glActiveTexture(GL_TEXTURE0);
 
@@ -448,12 +1985,37 @@ int main(const int argc, const char** argv)
     std::cout << "Done!\n";
 
     std::cout << "Building render texture... ";
-    initTexture(&screenTexture, int(SCR_RES.x), int(SCR_RES.y));
+    initGBuffer(int(SCR_RES.x), int(SCR_RES.y));
+    initPrepassBuffers(int(SCR_RES.x), int(SCR_RES.y));
+    initGraphTexture();
     std::cout << "Done!\n";
 
+    initBrickCache(options);
+
+    std::cout << "Watching res/ for shader changes... ";
+    shaderReloader.init(window);
+    shaderReloader.watch(screenShader, "screen", "screen");
+    shaderReloader.watch(graphShader, "screen", "graph");
+    RaytraceShaders& shaders = raytraceShaders[int(formula)];
+    shaderReloader.watch(shaders.compute, "raytrace", HasExtra::Yes, computeDefines(formula));
+    shaderReloader.watch(shaders.prepass, "raytrace", HasExtra::Yes, "#define CONE_PREPASS\n" + computeDefines(formula));
+    shaderReloader.watch(shaders.reproject, "raytrace", HasExtra::Yes, "#define REPROJECT\n" + computeDefines(formula));
+    shaders.requested = true;
+    std::cout << "Done! (" << shaderReloader.getModeName() << ")\n";
+
     std::cout << "Initializing engine...\n";
     init();
     std::cout << "Finished initializing engine! Fractalizing the renderer...\n";
 
-    run(window);
+    if (!options.record.empty() && !player.isOpen())
+    {
+        if (!recorder.open(options.record, currentStart()))
+            std::cout << "Failed to open \"" << options.record << "\" for recording!\n";
+        else
+            std::cout << "Recording input to \"" << options.record << "\"\n";
+    }
+
+    openCapture(options.capture, player.isOpen() ? FrameRate::fromFrameTime(player.getStart().deltaTime) : FrameRate());
+
+    run(window, options.csv);
 }
@@ -0,0 +1,331 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "Util.h"
+
+// how long close() and a full ring wait for the GPU, in nanoseconds
+constexpr GLuint64 FENCE_TIMEOUT = 1000000000;
+
+FrameCapture::~FrameCapture()
+{
+    // without a context the GL objects are gone with it anyway
+    if (writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        writer.join();
+    }
+
+    if (file)
+        fclose(file);
+}
+
+FrameRate FrameRate::perSecond(double framesPerSecond)
+{
+    framesPerSecond = std::max(framesPerSecond, 0.001);
+
+    // close enough to be what was meant, but not to a different NTSC rate
+    const auto closeTo = [](const double value) { return std::abs(value - std::round(value)) < value * 1e-4; };
+
+    if (closeTo(framesPerSecond))
+        return { int(std::lround(framesPerSecond)), 1 };
+    if (closeTo(framesPerSecond * 1.001))
+        return { int(std::lround(framesPerSecond * 1.001)) * 1000, 1001 };
+    return { int(std::lround(framesPerSecond * 1000)), 1000 };
+}
+
+FrameRate FrameRate::fromFrameTime(const double milliseconds)
+{
+    return perSecond(1000.0 / milliseconds);
+}
+
+bool FrameCapture::open(const std::string& path, const FrameRate frameRate, const bool numbered)
+{
+    close();
+
+    // the numbered files are opened one at a time as frames come in
+    if (!numbered)
+    {
+        file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            std::cout << "Failed to open \"" << path << "\" for writing!" << std::endl;
+            return false;
+        }
+    }
+
+    opened = true;
+    this->path = path;
+    this->numbered = numbered;
+
+    const size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c) { return char(tolower(c)); });
+    y4m = !numbered && extension == "y4m";
+
+    this->frameRate = frameRate;
+
+    glGenFramebuffers(1, &framebuffer);
+    for (Slot& slot : slots)
+    {
+        glGenBuffers(1, &slot.buffer);
+        slot.bufferSize = 0;
+        slot.fence = nullptr;
+    }
+    nextSlot = 0;
+    inFlight = 0;
+    captureCount = 0;
+
+    stopping = false;
+    streamSize = glm::ivec2(0);
+    writtenCount = 0;
+    droppedCount = 0;
+    writer = std::thread(&FrameCapture::writerLoop, this);
+
+    return true;
+}
+
+void FrameCapture::capture(const GLuint texture, const glm::ivec2& size)
+{
+    if (!opened || size.x <= 0 || size.y <= 0)
+        return;
+
+    collect(false);
+
+    // the GPU is a whole ring behind, nowhere to put this frame until it catches up
+    if (inFlight == RING)
+        collect(true);
+
+    Slot& slot = slots[nextSlot];
+    const GLsizeiptr bytes = GLsizeiptr(size.x) * size.y * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.bufferSize < bytes)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        slot.bufferSize = bytes;
+    }
+
+    // the compute shader wrote it as an image
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    // into the buffer, so this returns right away
+    glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.size = size;
+    slot.number = ++captureCount;
+
+    nextSlot = (nextSlot + 1) % RING;
+    inFlight++;
+}
+
+void FrameCapture::close()
+{
+    if (!opened)
+        return;
+
+    while (inFlight > 0)
+        collect(true);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+
+    if (file)
+        fclose(file);
+    file = nullptr;
+    opened = false;
+
+    for (Slot& slot : slots)
+    {
+        glDeleteBuffers(1, &slot.buffer);
+        slot.buffer = 0;
+    }
+    glDeleteFramebuffers(1, &framebuffer);
+    framebuffer = 0;
+
+    queue.clear();
+    spareBuffers.clear();
+}
+
+bool FrameCapture::isOpen() const
+{
+    return opened;
+}
+
+int FrameCapture::getWrittenCount() const
+{
+    return writtenCount;
+}
+
+int FrameCapture::getDroppedCount() const
+{
+    return droppedCount;
+}
+
+void FrameCapture::collect(bool wait)
+{
+    while (inFlight > 0)
+    {
+        Slot& slot = slots[(nextSlot - inFlight + RING) % RING];
+
+        const GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? FENCE_TIMEOUT : 0);
+        if (status == GL_TIMEOUT_EXPIRED && !wait)
+            return;
+        wait = false; // only for the oldest
+
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        inFlight--;
+
+        if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            droppedCount++;
+            continue;
+        }
+
+        Frame frame;
+        frame.size = slot.size;
+        frame.number = slot.number;
+        {
+            // room in the queue, and maybe a buffer the writer is done with
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return int(queue.size()) < MAX_QUEUED; });
+            if (!spareBuffers.empty())
+            {
+                frame.rgba = std::move(spareBuffers.back());
+                spareBuffers.pop_back();
+            }
+        }
+
+        const size_t bytes = size_t(slot.size.x) * slot.size.y * 4;
+        frame.rgba.resize(bytes);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        if (const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(bytes), GL_MAP_READ_BIT))
+        {
+            memcpy(frame.rgba.data(), pixels, bytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(frame));
+        }
+        wake.notify_one();
+    }
+}
+
+void FrameCapture::writerLoop()
+{
+    std::vector<uint8_t> scratch;
+
+    while (true)
+    {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                break; // stopping, and everything's written
+
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        const bool written = writeFrame(frame, scratch);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            (written ? writtenCount : droppedCount)++;
+            spareBuffers.push_back(std::move(frame.rgba));
+        }
+        done.notify_one();
+    }
+}
+
+bool FrameCapture::writeFrame(const Frame& frame, std::vector<uint8_t>& scratch)
+{
+    if (streamSize.x == 0)
+    {
+        streamSize = frame.size;
+
+        if (y4m)
+            fprintf(file, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C444\n", streamSize.x, streamSize.y, frameRate.numerator, frameRate.denominator);
+    }
+
+    if (frame.size != streamSize)
+        return false;
+
+    FILE* output = file;
+    if (numbered)
+    {
+        const std::string fileName = frameFileName(path, frame.number);
+        output = fopen(fileName.c_str(), "wb");
+        if (!output)
+            return false;
+    }
+
+    const size_t pixelCount = size_t(frame.size.x) * frame.size.y;
+    scratch.resize(pixelCount * 3);
+    const uint8_t* rgba = frame.rgba.data();
+
+    if (y4m)
+    {
+        // BT.601 in video range, each plane on its own
+        uint8_t* y = scratch.data();
+        uint8_t* u = y + pixelCount;
+        uint8_t* v = u + pixelCount;
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            const float r = rgba[i * 4 + 0];
+            const float g = rgba[i * 4 + 1];
+            const float b = rgba[i * 4 + 2];
+
+            y[i] = uint8_t(16.5f + 0.2568f * r + 0.5041f * g + 0.0979f * b);
+            u[i] = uint8_t(128.5f - 0.1482f * r - 0.2910f * g + 0.4392f * b);
+            v[i] = uint8_t(128.5f + 0.4392f * r - 0.3678f * g - 0.0714f * b);
+        }
+
+        fputs("FRAME\n", output);
+    }
+    else
+    {
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            scratch[i * 3 + 0] = rgba[i * 4 + 0];
+            scratch[i * 3 + 1] = rgba[i * 4 + 1];
+            scratch[i * 3 + 2] = rgba[i * 4 + 2];
+        }
+
+        fprintf(output, "P6\n%d %d\n255\n", frame.size.x, frame.size.y);
+    }
+
+    const bool written = fwrite(scratch.data(), 1, scratch.size(), output) == scratch.size();
+    if (numbered)
+        return fclose(output) == 0 && written;
+
+    return written;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// frames per second as a fraction, the way Y4M stores it
+struct FrameRate
+{
+    int numerator = 60;
+    int denominator = 1;
+
+    // Whole numbers and the NTSC rates (30000/1001 and so on) come out exact, anything else to a
+    // thousandth of a frame. A replay's frame time is in milliseconds, so 16.666 is 60 too
+    static FrameRate perSecond(double framesPerSecond);
+    static FrameRate fromFrameTime(double milliseconds);
+};
+
+// Streams rendered frames to a raw video file without stalling the GPU. Each frame is
+// read into one of a ring of pixel pack buffers and fenced, and only mapped once the
+// fence says the copy is done, RING - 1 frames later, so frame N is read while N + 2
+// renders. A worker thread converts and writes the frames: .y4m gets a YUV4MPEG2
+// 4:4:4 stream, anything else a stream of binary PPMs, both of which ffmpeg reads,
+// or with numbered every frame is a PPM of its own, "frames.ppm" -> "frames_0001.ppm".
+// The stream's size is the first frame's, frames of any other size are dropped.
+class FrameCapture
+{
+public:
+    static constexpr int RING = 3;
+
+    // frames converted or waiting to be, capture() waits for the writer past this
+    static constexpr int MAX_QUEUED = 8;
+
+    FrameCapture() = default;
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // needs a current OpenGL context
+    bool open(const std::string& path, FrameRate frameRate, bool numbered = false);
+
+    // reads the size corner of texture once the GPU gets there. Call after the frame's last dispatch
+    void capture(GLuint texture, const glm::ivec2& size);
+
+    // waits for the frames in flight to be written, then closes the file. Call with the context still current!
+    void close();
+
+    bool isOpen() const;
+
+    // final once close() returns
+    int getWrittenCount() const;
+    int getDroppedCount() const;
+
+private:
+    struct Slot
+    {
+        GLuint buffer = 0;
+        GLsizeiptr bufferSize = 0;
+        GLsync fence = nullptr;
+        glm::ivec2 size{ 0 };
+        int number = 0;
+    };
+
+    struct Frame
+    {
+        glm::ivec2 size{ 0 };
+        int number = 0; // counting captures from 1
+        std::vector<uint8_t> rgba;
+    };
+
+    // hands the oldest slots whose copies are done to the writer, waiting for the first if wait
+    void collect(bool wait);
+
+    void writerLoop();
+    bool writeFrame(const Frame& frame, std::vector<uint8_t>& scratch);
+
+    bool opened = false;
+    FILE* file = nullptr; // unless numbered
+    std::string path;
+    bool numbered = false;
+    bool y4m = false;
+    FrameRate frameRate;
+
+    GLuint framebuffer = 0;
+    Slot slots[RING];
+    int nextSlot = 0; // the one capture() fills next
+    int inFlight = 0; // slots before nextSlot still waiting for their fence
+    int captureCount = 0;
+
+    // shared with the writer
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake; // the writer has something to do
+    std::condition_variable done; // capture() has room in the queue
+    std::deque<Frame> queue;
+    std::vector<std::vector<uint8_t>> spareBuffers;
+    bool stopping = false;
+    glm::ivec2 streamSize{ 0 };
+    int writtenCount = 0;
+    int droppedCount = 0;
+};
@@ -0,0 +1,227 @@
+#include "FrameTimer.h"
+
+const char* stageName(const Stage stage)
+{
+    switch (stage)
+    {
+    case Stage::Update: return "update";
+    case Stage::Raytrace: return "raytrace";
+    case Stage::Capture: return "capture";
+    case Stage::Screen: return "screen";
+    case Stage::Swap: return "swap";
+    }
+    return "unknown";
+}
+
+namespace
+{
+    float millisecondsSince(const std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+FrameTimer::~FrameTimer()
+{
+    // too late for the queries, the context is probably gone by now
+    if (csv)
+        fclose(csv);
+}
+
+void FrameTimer::init()
+{
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        glGenQueries(QUERY_RING, queries[stage]);
+        for (int slot = 0; slot < QUERY_RING; slot++)
+            queryFrame[stage][slot] = -1;
+    }
+
+    initialized = true;
+}
+
+void FrameTimer::destroy()
+{
+    if (currentFrame >= 0)
+        frameAt(currentFrame).frame = millisecondsSince(frameStart);
+
+    if (initialized)
+    {
+        collectQueries(true);
+
+        for (int stage = 0; stage < STAGE_COUNT; stage++)
+            glDeleteQueries(QUERY_RING, queries[stage]);
+        initialized = false;
+    }
+
+    if (csv)
+    {
+        while (csvFrame <= currentFrame)
+            writeCsv(csvFrame++);
+
+        fclose(csv);
+        csv = nullptr;
+    }
+}
+
+bool FrameTimer::openCsv(const std::string& path)
+{
+    csv = fopen(path.c_str(), "w");
+    if (!csv)
+        return false;
+
+    fprintf(csv, "frame,frame_ms");
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+        fprintf(csv, ",cpu_%s_ms", stageName(Stage(stage)));
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+        fprintf(csv, ",gpu_%s_ms", stageName(Stage(stage)));
+    fprintf(csv, "\n");
+
+    csvFrame = currentFrame + 1;
+    return true;
+}
+
+void FrameTimer::beginFrame()
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (currentFrame >= 0)
+        frameAt(currentFrame).frame = std::chrono::duration<float, std::milli>(now - frameStart).count();
+    frameStart = now;
+
+    if (initialized)
+        collectQueries(false);
+
+    currentFrame++;
+
+    FrameTimes& times = frameAt(currentFrame);
+    times = FrameTimes();
+    for (float& gpu : times.gpu)
+        gpu = -1;
+
+    // only use a query whose last result has been collected
+    const int slot = int(currentFrame % QUERY_RING);
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+        activeQuery[stage] = (initialized && queryFrame[stage][slot] < 0) ? slot : -1;
+
+    // older frames have had QUERY_RING frames to finish on the GPU
+    if (csv)
+    {
+        while (csvFrame < currentFrame - QUERY_RING)
+            writeCsv(csvFrame++);
+    }
+}
+
+void FrameTimer::beginStage(const Stage stage)
+{
+    const int s = int(stage);
+
+    stageStart[s] = std::chrono::steady_clock::now();
+
+    const int slot = activeQuery[s];
+    if (slot >= 0)
+    {
+        glBeginQuery(GL_TIME_ELAPSED, queries[s][slot]);
+        queryFrame[s][slot] = currentFrame;
+    }
+}
+
+void FrameTimer::endStage(const Stage stage)
+{
+    const int s = int(stage);
+
+    frameAt(currentFrame).cpu[s] += millisecondsSince(stageStart[s]);
+
+    if (activeQuery[s] >= 0)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        activeQuery[s] = -1;
+    }
+}
+
+const FrameTimes& FrameTimer::getFrame(const int age) const
+{
+    const long long frame = currentFrame - age;
+    return history[((frame % HISTORY) + HISTORY) % HISTORY];
+}
+
+void FrameTimer::getGraph(std::vector<float>& out) const
+{
+    out.assign(size_t(HISTORY) * 2 * STAGE_COUNT, 0.f);
+
+    for (int x = 0; x < HISTORY; x++)
+    {
+        const int age = HISTORY - 1 - x;
+        if (age > currentFrame)
+            continue; // not rendered yet
+
+        const FrameTimes& times = getFrame(age);
+        for (int stage = 0; stage < STAGE_COUNT; stage++)
+        {
+            out[size_t(stage) * HISTORY + x] = times.cpu[stage];
+            out[size_t(STAGE_COUNT + stage) * HISTORY + x] = times.gpu[stage] > 0 ? times.gpu[stage] : 0.f;
+        }
+    }
+}
+
+void FrameTimer::collectQueries(const bool wait)
+{
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        for (int slot = 0; slot < QUERY_RING; slot++)
+        {
+            const long long frame = queryFrame[stage][slot];
+            if (frame < 0)
+                continue;
+
+            if (!wait)
+            {
+                GLint available = 0;
+                glGetQueryObjectiv(queries[stage][slot], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    continue;
+            }
+
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[stage][slot], GL_QUERY_RESULT, &nanoseconds);
+            queryFrame[stage][slot] = -1;
+
+            if (currentFrame - frame < HISTORY)
+                frameAt(frame).gpu[stage] = float(double(nanoseconds) / 1e6);
+        }
+    }
+}
+
+void FrameTimer::writeCsv(const long long frame)
+{
+    if (currentFrame - frame >= HISTORY)
+        return;
+
+    const FrameTimes& times = frameAt(frame);
+
+    fprintf(csv, "%lld,%f", frame, times.frame);
+    for (const float cpu : times.cpu)
+        fprintf(csv, ",%f", cpu);
+    for (const float gpu : times.gpu)
+    {
+        if (gpu < 0)
+            fprintf(csv, ",");
+        else
+            fprintf(csv, ",%f", gpu);
+    }
+    fprintf(csv, "\n");
+}
+
+FrameTimes& FrameTimer::frameAt(const long long frame)
+{
+    return history[frame % HISTORY];
+}
+
+ScopedStage::ScopedStage(FrameTimer& timer, const Stage stage) : timer(timer), stage(stage)
+{
+    timer.beginStage(stage);
+}
+
+ScopedStage::~ScopedStage()
+{
+    timer.endStage(stage);
+}
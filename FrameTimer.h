@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// The parts of a frame in run(), in order
+enum class Stage { Update, Raytrace, Capture, Screen, Swap };
+
+constexpr int STAGE_COUNT = 5;
+
+const char* stageName(Stage stage);
+
+// CPU and GPU milliseconds spent in each stage of one frame
+struct FrameTimes
+{
+    float frame = 0; // CPU time from this frame's start to the next one's
+    float cpu[STAGE_COUNT] = {};
+    float gpu[STAGE_COUNT] = {}; // negative until the query result arrives, or if it was dropped
+};
+
+// Times every Stage on the CPU and, through a ring of GL_TIME_ELAPSED queries,
+// on the GPU. Query results are only collected once the GPU says they're
+// available, a few frames later, so timing never stalls the pipeline. If the
+// GPU falls a whole ring behind, that frame's GPU time is dropped instead.
+class FrameTimer
+{
+public:
+    static constexpr int HISTORY = 256;
+    static constexpr int QUERY_RING = 4;
+
+    FrameTimer() = default;
+    ~FrameTimer();
+
+    FrameTimer(const FrameTimer&) = delete;
+    FrameTimer& operator=(const FrameTimer&) = delete;
+
+    // needs a current OpenGL context
+    void init();
+
+    // collects finished queries and forgets everything. Call with the context still current!
+    void destroy();
+
+    // writes a row per frame, a few frames late so the GPU times are in
+    bool openCsv(const std::string& path);
+
+    void beginFrame();
+
+    void beginStage(Stage stage);
+    void endStage(Stage stage);
+
+    // age 0 is the current frame
+    const FrameTimes& getFrame(int age) const;
+
+    // the whole history for a HISTORY x (2 * STAGE_COUNT) texture, oldest frame first.
+    // The first STAGE_COUNT rows are CPU times, the rest GPU times (0 if unknown)
+    void getGraph(std::vector<float>& out) const;
+
+private:
+    void collectQueries(bool wait);
+
+    void writeCsv(long long frame);
+
+    FrameTimes& frameAt(long long frame);
+
+    GLuint queries[STAGE_COUNT][QUERY_RING] = {};
+    long long queryFrame[STAGE_COUNT][QUERY_RING] = {}; // -1 when free
+    int activeQuery[STAGE_COUNT] = {}; // slot of this frame's query, -1 if none
+
+    std::chrono::steady_clock::time_point frameStart;
+    std::chrono::steady_clock::time_point stageStart[STAGE_COUNT];
+
+    FrameTimes history[HISTORY];
+    long long currentFrame = -1;
+
+    FILE* csv = nullptr;
+    long long csvFrame = 0; // next row to write
+
+    bool initialized = false;
+};
+
+// times a Stage until it goes out of scope
+class ScopedStage
+{
+public:
+    ScopedStage(FrameTimer& timer, Stage stage);
+    ~ScopedStage();
+
+    ScopedStage(const ScopedStage&) = delete;
+    ScopedStage& operator=(const ScopedStage&) = delete;
+
+private:
+    FrameTimer& timer;
+    Stage stage;
+};
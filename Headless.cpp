@@ -0,0 +1,203 @@
+#include "Headless.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef FRACTAL4D_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef FRACTAL4D_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+namespace
+{
+#ifdef FRACTAL4D_EGL
+    void* eglLoader(const char* name)
+    {
+        return reinterpret_cast<void*>(eglGetProcAddress(name));
+    }
+
+    bool hasExtension(const char* extensions, const char* name)
+    {
+        if (!extensions)
+            return false;
+
+        const size_t length = strlen(name);
+        for (const char* found = strstr(extensions, name); found; found = strstr(found + length, name)) {
+            if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+                return true;
+        }
+
+        return false;
+    }
+#endif
+
+#ifdef FRACTAL4D_OSMESA
+    void* osmesaLoader(const char* name)
+    {
+        return reinterpret_cast<void*>(OSMesaGetProcAddress(name));
+    }
+#endif
+}
+
+HeadlessContext::~HeadlessContext()
+{
+#ifdef FRACTAL4D_EGL
+    if (eglDisplay) {
+        eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (eglContext)
+            eglDestroyContext(eglDisplay, eglContext);
+        eglTerminate(eglDisplay);
+    }
+#endif
+
+#ifdef FRACTAL4D_OSMESA
+    if (osmesaContext)
+        OSMesaDestroyContext(static_cast<OSMesaContext>(osmesaContext));
+#endif
+}
+
+bool HeadlessContext::create()
+{
+#ifdef FRACTAL4D_EGL
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if (getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        if (createEGL(getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr))) {
+            backend = "EGL surfaceless";
+            return true;
+        }
+    }
+
+    const auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+
+    if (getPlatformDisplay && queryDevices && hasExtension(clientExtensions, "EGL_EXT_platform_device")) {
+        EGLDeviceEXT device;
+        EGLint deviceCount = 0;
+
+        if (queryDevices(1, &device, &deviceCount) && deviceCount > 0 &&
+            createEGL(getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, device, nullptr))) {
+            backend = "EGL device";
+            return true;
+        }
+    }
+
+    if (createEGL(eglGetDisplay(EGL_DEFAULT_DISPLAY))) {
+        backend = "EGL default display";
+        return true;
+    }
+#endif
+
+#ifdef FRACTAL4D_OSMESA
+    const int attributes[] = {
+        OSMESA_FORMAT, OSMESA_RGBA,
+        OSMESA_DEPTH_BITS, 0,
+        OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, 4,
+        OSMESA_CONTEXT_MINOR_VERSION, 3,
+        0
+    };
+
+    const OSMesaContext context = OSMesaCreateContextAttribs(attributes, nullptr);
+    if (context) {
+        // OSMesa insists on a color buffer, but we only ever render to textures
+        osmesaBuffer.resize(4);
+        if (OSMesaMakeCurrent(context, osmesaBuffer.data(), GL_UNSIGNED_BYTE, 1, 1)) {
+            osmesaContext = context;
+            backend = "OSMesa";
+            return true;
+        }
+
+        OSMesaDestroyContext(context);
+    }
+#endif
+
+    return false;
+}
+
+GLADloadproc HeadlessContext::getLoader() const
+{
+#ifdef FRACTAL4D_EGL
+    if (eglContext)
+        return eglLoader;
+#endif
+
+#ifdef FRACTAL4D_OSMESA
+    if (osmesaContext)
+        return osmesaLoader;
+#endif
+
+    return nullptr;
+}
+
+const std::string& HeadlessContext::getBackendName() const
+{
+    return backend;
+}
+
+#ifdef FRACTAL4D_EGL
+bool HeadlessContext::createEGL(void* display)
+{
+    if (display == EGL_NO_DISPLAY)
+        return false;
+
+    EGLint major, minor;
+    if (!eglInitialize(display, &major, &minor))
+        return false;
+
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+
+    // we never draw to a surface, so skip it altogether if the driver lets us
+    if (!hasExtension(extensions, "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API)) {
+        eglTerminate(display);
+        return false;
+    }
+
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        if (!hasExtension(extensions, "EGL_KHR_no_config_context")) {
+            eglTerminate(display);
+            return false;
+        }
+
+        config = nullptr; // EGL_NO_CONFIG_KHR
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    const EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        eglTerminate(display);
+        return false;
+    }
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        return false;
+    }
+
+    eglDisplay = display;
+    eglContext = context;
+
+    std::cout << "(EGL " << major << "." << minor << ") ";
+    return true;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// An offscreen OpenGL 4.3 core context with no window and no swap chain, for
+// servers without a display. Tries EGL first (Mesa's surfaceless platform,
+// then the first EGL device, then the default display) and OSMesa after that,
+// depending on which ones this build was compiled with.
+class HeadlessContext
+{
+public:
+    HeadlessContext() = default;
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    // creates the context and makes it current on this thread
+    bool create();
+
+    // for gladLoadGLLoader
+    GLADloadproc getLoader() const;
+
+    // which of the backends worked
+    const std::string& getBackendName() const;
+
+private:
+#ifdef FRACTAL4D_EGL
+    bool createEGL(void* display);
+#endif
+
+    // EGLDisplay and EGLContext, kept as void* so EGL's headers stay out of here
+    void* eglDisplay = nullptr;
+    void* eglContext = nullptr;
+
+    void* osmesaContext = nullptr;
+    std::vector<unsigned char> osmesaBuffer;
+
+    std::string backend = "none";
+};
\ No newline at end of file
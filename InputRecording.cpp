@@ -0,0 +1,212 @@
+#include "InputRecording.h"
+
+#include <cstring>
+
+// header: magic, version, deltaTime, cameraPos, cameraYaw, cameraPitch, moveSpeed, detail
+// frame: timestamp, look, flags, scroll, detail, padding
+constexpr char MAGIC[4] = { 'F', '4', 'D', 'I' };
+constexpr uint32_t VERSION = 1;
+constexpr long HEADER_SIZE = 40;
+constexpr long FRAME_SIZE = 16;
+
+// flags bits
+constexpr uint8_t JUMP = 1 << 0;
+constexpr uint8_t SNEAK = 1 << 1;
+constexpr int FORWARD_SHIFT = 2; // 2 bits each, stored as value + 1
+constexpr int RIGHT_SHIFT = 4;
+
+namespace
+{
+    void putU32(uint8_t* out, const uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            out[i] = uint8_t(value >> (i * 8));
+    }
+
+    uint32_t getU32(const uint8_t* in)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++)
+            value |= uint32_t(in[i]) << (i * 8);
+        return value;
+    }
+
+    void putFloat(uint8_t* out, const float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        putU32(out, bits);
+    }
+
+    float getFloat(const uint8_t* in)
+    {
+        const uint32_t bits = getU32(in);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    int clampByte(const int value)
+    {
+        return value < -128 ? -128 : (value > 127 ? 127 : value);
+    }
+}
+
+InputRecorder::~InputRecorder()
+{
+    close();
+}
+
+bool InputRecorder::open(const std::string& path, const InputStart& start)
+{
+    close();
+
+    file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    uint8_t header[HEADER_SIZE] = {};
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    putU32(header + 4, VERSION);
+    putFloat(header + 8, start.deltaTime);
+    putFloat(header + 12, start.cameraPos.x);
+    putFloat(header + 16, start.cameraPos.y);
+    putFloat(header + 20, start.cameraPos.z);
+    putFloat(header + 24, start.cameraYaw);
+    putFloat(header + 28, start.cameraPitch);
+    putFloat(header + 32, start.moveSpeed);
+    putU32(header + 36, uint32_t(start.detail));
+
+    if (fwrite(header, sizeof(header), 1, file) != 1)
+    {
+        close();
+        return false;
+    }
+
+    frameCount = 0;
+    return true;
+}
+
+void InputRecorder::record(const InputFrame& frame)
+{
+    if (!file)
+        return;
+
+    uint8_t flags = 0;
+    if (frame.jump)
+        flags |= JUMP;
+    if (frame.sneak)
+        flags |= SNEAK;
+    flags |= uint8_t((glm::clamp(frame.forward, -1, 1) + 1) << FORWARD_SHIFT);
+    flags |= uint8_t((glm::clamp(frame.right, -1, 1) + 1) << RIGHT_SHIFT);
+
+    uint8_t data[FRAME_SIZE] = {};
+    putFloat(data, frame.timestamp);
+    putFloat(data + 4, frame.look.x);
+    putFloat(data + 8, frame.look.y);
+    data[12] = flags;
+    data[13] = uint8_t(int8_t(clampByte(frame.scroll)));
+    data[14] = uint8_t(int8_t(clampByte(frame.detail)));
+
+    fwrite(data, sizeof(data), 1, file);
+    frameCount++;
+}
+
+void InputRecorder::close()
+{
+    if (file)
+        fclose(file);
+    file = nullptr;
+}
+
+bool InputRecorder::isOpen() const
+{
+    return file != nullptr;
+}
+
+int InputRecorder::getFrameCount() const
+{
+    return frameCount;
+}
+
+InputPlayer::~InputPlayer()
+{
+    close();
+}
+
+bool InputPlayer::open(const std::string& path)
+{
+    close();
+
+    file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    uint8_t header[HEADER_SIZE];
+    if (fread(header, sizeof(header), 1, file) != 1 || memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || getU32(header + 4) != VERSION)
+    {
+        close();
+        return false;
+    }
+
+    start.deltaTime = getFloat(header + 8);
+    start.cameraPos = glm::vec3(getFloat(header + 12), getFloat(header + 16), getFloat(header + 20));
+    start.cameraYaw = getFloat(header + 24);
+    start.cameraPitch = getFloat(header + 28);
+    start.moveSpeed = getFloat(header + 32);
+    start.detail = int(int32_t(getU32(header + 36)));
+
+    // no frame count in the header, so a recording cut short by a crash still plays
+    fseek(file, 0, SEEK_END);
+    frameCount = int((ftell(file) - HEADER_SIZE) / FRAME_SIZE);
+    fseek(file, HEADER_SIZE, SEEK_SET);
+
+    framesRead = 0;
+    return true;
+}
+
+bool InputPlayer::next(InputFrame& frame)
+{
+    if (!file || framesRead >= frameCount)
+        return false;
+
+    uint8_t data[FRAME_SIZE];
+    if (fread(data, sizeof(data), 1, file) != 1)
+        return false;
+
+    const uint8_t flags = data[12];
+
+    frame.timestamp = getFloat(data);
+    frame.look = glm::vec2(getFloat(data + 4), getFloat(data + 8));
+    frame.jump = (flags & JUMP) != 0;
+    frame.sneak = (flags & SNEAK) != 0;
+    frame.forward = int((flags >> FORWARD_SHIFT) & 3) - 1;
+    frame.right = int((flags >> RIGHT_SHIFT) & 3) - 1;
+    frame.scroll = int8_t(data[13]);
+    frame.detail = int8_t(data[14]);
+
+    framesRead++;
+    return true;
+}
+
+void InputPlayer::close()
+{
+    if (file)
+        fclose(file);
+    file = nullptr;
+}
+
+bool InputPlayer::isOpen() const
+{
+    return file != nullptr;
+}
+
+const InputStart& InputPlayer::getStart() const
+{
+    return start;
+}
+
+int InputPlayer::getFrameCount() const
+{
+    return frameCount;
+}
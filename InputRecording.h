@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <glm/glm.hpp>
+
+// What the player did during one frame. The mouse and scroll wheel are
+// accumulated since the previous frame, so replaying them doesn't depend on
+// how often GLFW happened to call our callbacks.
+struct InputFrame
+{
+    float timestamp = 0; // ms since the recording started
+
+    glm::vec2 look = glm::vec2(0); // mouse movement in pixels, y up
+    int forward = 0; // -1, 0 or 1
+    int right = 0;
+    bool jump = false;
+    bool sneak = false;
+
+    int scroll = 0; // wheel clicks, positive is up
+    int detail = 0; // SCR_DETAIL change
+};
+
+// Where the flight started, so a replay starts there too
+struct InputStart
+{
+    glm::vec3 cameraPos = glm::vec3(0);
+    float cameraYaw = 0;
+    float cameraPitch = 0;
+    float moveSpeed = 1;
+    int detail = 0;
+
+    float deltaTime = 16.666f; // fixed frame time used on replay
+};
+
+// Writes a .f4di file: a header with the InputStart, then 16 bytes per frame.
+// Everything is little endian so recordings work across machines.
+class InputRecorder
+{
+public:
+    InputRecorder() = default;
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    bool open(const std::string& path, const InputStart& start);
+
+    void record(const InputFrame& frame);
+
+    void close();
+
+    bool isOpen() const;
+
+    int getFrameCount() const;
+
+private:
+    FILE* file = nullptr;
+    int frameCount = 0;
+};
+
+// Reads back what InputRecorder wrote
+class InputPlayer
+{
+public:
+    InputPlayer() = default;
+    ~InputPlayer();
+
+    InputPlayer(const InputPlayer&) = delete;
+    InputPlayer& operator=(const InputPlayer&) = delete;
+
+    bool open(const std::string& path);
+
+    // false once the recording is over
+    bool next(InputFrame& frame);
+
+    void close();
+
+    bool isOpen() const;
+
+    const InputStart& getStart() const;
+
+    int getFrameCount() const;
+
+private:
+    FILE* file = nullptr;
+    InputStart start;
+    int frameCount = 0;
+    int framesRead = 0;
+};
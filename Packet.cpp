@@ -0,0 +1,196 @@
+#include "Packet.h"
+
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+
+#include "PacketKernel.h"
+
+#if defined(FRACTAL4D_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef FRACTAL4D_X86_SIMD
+const PacketKernels& sse4Kernels();
+const PacketKernels& avx2Kernels();
+const PacketKernels& avx512Kernels();
+#endif
+
+namespace
+{
+    // one lane at a time, the reference the SIMD versions are validated against
+    struct ScalarLanes
+    {
+        using F = float;
+        using I = uint32_t;
+        using M = bool;
+
+        static constexpr int width = 1;
+
+        static F set(const float v) { return v; }
+        static I seti(const int32_t v) { return I(v); }
+        static F load(const float* p) { return *p; }
+        static void store(float* p, const F v) { *p = v; }
+        static void storei(int* p, const I v) { *p = int(v); }
+
+        static F add(const F a, const F b) { return a + b; }
+        static F sub(const F a, const F b) { return a - b; }
+        static F mul(const F a, const F b) { return a * b; }
+        static F div(const F a, const F b) { return a / b; }
+        static F sqrt(const F a) { return std::sqrt(a); }
+        // same NaN behaviour as minps/maxps
+        static F min(const F a, const F b) { return a < b ? a : b; }
+        static F max(const F a, const F b) { return a > b ? a : b; }
+
+        static M lt(const F a, const F b) { return a < b; }
+        static M gt(const F a, const F b) { return a > b; }
+        static M eqi(const I a, const I b) { return a == b; }
+        static M gti(const I a, const I b) { return int32_t(a) > int32_t(b); }
+
+        static M all() { return true; }
+        static M mandnot(const M a, const M b) { return a && !b; }
+        static bool any(const M m) { return m; }
+
+        static F select(const M m, const F t, const F f) { return m ? t : f; }
+        static I selecti(const M m, const I t, const I f) { return m ? t : f; }
+
+        static I cvtt(const F v) { return I(int32_t(v)); }
+        static F cvt(const I v) { return float(int32_t(v)); }
+        static I bits(const F v) { I i; memcpy(&i, &v, sizeof(i)); return i; }
+        static F floats(const I v) { F f; memcpy(&f, &v, sizeof(f)); return f; }
+
+        static I addi(const I a, const I b) { return a + b; }
+        static I subi(const I a, const I b) { return a - b; }
+        static I andi(const I a, const I b) { return a & b; }
+        static I ori(const I a, const I b) { return a | b; }
+        static I xori(const I a, const I b) { return a ^ b; }
+        static I slli(const I a, const int n) { return a << n; }
+        static I srli(const I a, const int n) { return a >> n; }
+    };
+
+    const PacketKernels scalarKernels = PacketKernel::makeKernels<ScalarLanes>(SimdLevel::Scalar);
+
+#ifdef FRACTAL4D_X86_SIMD
+    bool cpuSupports(const SimdLevel level)
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        const bool sse41 = (info[2] & (1 << 19)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (level == SimdLevel::SSE4)
+            return sse41;
+
+        // the OS also needs to save the wider registers on context switches
+        if (!osxsave || maxLeaf < 7)
+            return false;
+        const unsigned long long xcr0 = _xgetbv(0);
+
+        __cpuidex(info, 7, 0);
+        if (level == SimdLevel::AVX2)
+            return (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+
+        return (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+#else
+        __builtin_cpu_init();
+
+        switch (level) {
+        case SimdLevel::SSE4:
+            return __builtin_cpu_supports("sse4.1");
+        case SimdLevel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case SimdLevel::AVX512:
+            return __builtin_cpu_supports("avx512f");
+        default:
+            return false;
+        }
+#endif
+    }
+#endif
+}
+
+SimdLevel Packet::bestLevel()
+{
+    for (const SimdLevel level : { SimdLevel::AVX512, SimdLevel::AVX2, SimdLevel::SSE4 }) {
+        if (isSupported(level))
+            return level;
+    }
+
+    return SimdLevel::Scalar;
+}
+
+bool Packet::isSupported(const SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Reference:
+    case SimdLevel::Scalar:
+        return true;
+#ifdef FRACTAL4D_X86_SIMD
+    case SimdLevel::SSE4:
+    case SimdLevel::AVX2:
+    case SimdLevel::AVX512:
+        return cpuSupports(level);
+#endif
+    default:
+        return false;
+    }
+}
+
+const PacketKernels* Packet::kernels(const SimdLevel level)
+{
+    if (!isSupported(level))
+        return nullptr;
+
+    switch (level) {
+    case SimdLevel::Scalar:
+        return &scalarKernels;
+#ifdef FRACTAL4D_X86_SIMD
+    case SimdLevel::SSE4:
+        return &sse4Kernels();
+    case SimdLevel::AVX2:
+        return &avx2Kernels();
+    case SimdLevel::AVX512:
+        return &avx512Kernels();
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const char* Packet::levelName(const SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Reference:
+        return "reference";
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::SSE4:
+        return "sse4";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::AVX512:
+        return "avx512";
+    }
+
+    return "unknown";
+}
+
+bool Packet::parseLevel(const char* name, SimdLevel& level)
+{
+    if (strcmp(name, "auto") == 0) {
+        level = bestLevel();
+        return true;
+    }
+
+    for (const SimdLevel candidate : { SimdLevel::Reference, SimdLevel::Scalar, SimdLevel::SSE4, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+        if (strcmp(name, levelName(candidate)) == 0) {
+            level = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Which kernel the CPU renderer marches rays with
+enum class SimdLevel
+{
+    Reference, // Fractal.cpp, one ray at a time with std:: math
+    Scalar,    // the packet kernel one lane at a time, bit-identical to the SIMD ones
+    SSE4,
+    AVX2,
+    AVX512
+};
+
+// Ray packet versions of DE and rayMarch from res/raytrace.comp. Rays are
+// stored SoA and processed 4 (SSE4), 8 (AVX2) or 16 (AVX-512) at a time;
+// count doesn't need to be a multiple of the width.
+struct PacketKernels
+{
+    SimdLevel level;
+    int width;
+
+    void (*de)(const float* x, const float* y, const float* z, float* dist, int count);
+
+    // travelDist is inout, just like the shader; deCalls counts DE evaluations per ray
+    void (*rayMarch)(const glm::vec3& origin, const float* dirX, const float* dirY, const float* dirZ,
+                     float* travelDist, int* steps, int* deCalls, int count);
+};
+
+namespace Packet
+{
+    // fastest level supported by both this build and this CPU
+    SimdLevel bestLevel();
+
+    bool isSupported(SimdLevel level);
+
+    // nullptr for SimdLevel::Reference or when unsupported
+    const PacketKernels* kernels(SimdLevel level);
+
+    const char* levelName(SimdLevel level);
+
+    // accepts the names from levelName, plus "auto" for bestLevel()
+    bool parseLevel(const char* name, SimdLevel& level);
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include <immintrin.h>
+
+#include "PacketKernel.h"
+
+// built with -mavx2 (see CMakeLists.txt), only called after a CPUID check
+namespace
+{
+    struct AVX2Lanes
+    {
+        using F = __m256;
+        using I = __m256i;
+        using M = __m256;
+
+        static constexpr int width = 8;
+
+        static F set(const float v) { return _mm256_set1_ps(v); }
+        static I seti(const int32_t v) { return _mm256_set1_epi32(v); }
+        static F load(const float* p) { return _mm256_loadu_ps(p); }
+        static void store(float* p, const F v) { _mm256_storeu_ps(p, v); }
+        static void storei(int* p, const I v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+        static F add(const F a, const F b) { return _mm256_add_ps(a, b); }
+        static F sub(const F a, const F b) { return _mm256_sub_ps(a, b); }
+        static F mul(const F a, const F b) { return _mm256_mul_ps(a, b); }
+        static F div(const F a, const F b) { return _mm256_div_ps(a, b); }
+        static F sqrt(const F a) { return _mm256_sqrt_ps(a); }
+        static F min(const F a, const F b) { return _mm256_min_ps(a, b); }
+        static F max(const F a, const F b) { return _mm256_max_ps(a, b); }
+
+        static M lt(const F a, const F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static M gt(const F a, const F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static M eqi(const I a, const I b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+        static M gti(const I a, const I b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b)); }
+
+        static M all() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+        static M mandnot(const M a, const M b) { return _mm256_andnot_ps(b, a); }
+        static bool any(const M m) { return _mm256_movemask_ps(m) != 0; }
+
+        static F select(const M m, const F t, const F f) { return _mm256_blendv_ps(f, t, m); }
+        static I selecti(const M m, const I t, const I f) { return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(f), _mm256_castsi256_ps(t), m)); }
+
+        static I cvtt(const F v) { return _mm256_cvttps_epi32(v); }
+        static F cvt(const I v) { return _mm256_cvtepi32_ps(v); }
+        static I bits(const F v) { return _mm256_castps_si256(v); }
+        static F floats(const I v) { return _mm256_castsi256_ps(v); }
+
+        static I addi(const I a, const I b) { return _mm256_add_epi32(a, b); }
+        static I subi(const I a, const I b) { return _mm256_sub_epi32(a, b); }
+        static I andi(const I a, const I b) { return _mm256_and_si256(a, b); }
+        static I ori(const I a, const I b) { return _mm256_or_si256(a, b); }
+        static I xori(const I a, const I b) { return _mm256_xor_si256(a, b); }
+        static I slli(const I a, const int n) { return _mm256_slli_epi32(a, n); }
+        static I srli(const I a, const int n) { return _mm256_srli_epi32(a, n); }
+    };
+}
+
+const PacketKernels& avx2Kernels()
+{
+    static const PacketKernels kernels = PacketKernel::makeKernels<AVX2Lanes>(SimdLevel::AVX2);
+    return kernels;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include <immintrin.h>
+
+#include "PacketKernel.h"
+
+// built with -mavx512f (see CMakeLists.txt), only called after a CPUID check
+namespace
+{
+    struct AVX512Lanes
+    {
+        using F = __m512;
+        using I = __m512i;
+        using M = __mmask16;
+
+        static constexpr int width = 16;
+
+        static F set(const float v) { return _mm512_set1_ps(v); }
+        static I seti(const int32_t v) { return _mm512_set1_epi32(v); }
+        static F load(const float* p) { return _mm512_loadu_ps(p); }
+        static void store(float* p, const F v) { _mm512_storeu_ps(p, v); }
+        static void storei(int* p, const I v) { _mm512_storeu_si512(p, v); }
+
+        static F add(const F a, const F b) { return _mm512_add_ps(a, b); }
+        static F sub(const F a, const F b) { return _mm512_sub_ps(a, b); }
+        static F mul(const F a, const F b) { return _mm512_mul_ps(a, b); }
+        static F div(const F a, const F b) { return _mm512_div_ps(a, b); }
+        static F sqrt(const F a) { return _mm512_sqrt_ps(a); }
+        static F min(const F a, const F b) { return _mm512_min_ps(a, b); }
+        static F max(const F a, const F b) { return _mm512_max_ps(a, b); }
+
+        static M lt(const F a, const F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+        static M gt(const F a, const F b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+        static M eqi(const I a, const I b) { return _mm512_cmpeq_epi32_mask(a, b); }
+        static M gti(const I a, const I b) { return _mm512_cmpgt_epi32_mask(a, b); }
+
+        static M all() { return M(0xffff); }
+        static M mandnot(const M a, const M b) { return M(a & ~b); }
+        static bool any(const M m) { return m != 0; }
+
+        static F select(const M m, const F t, const F f) { return _mm512_mask_blend_ps(m, f, t); }
+        static I selecti(const M m, const I t, const I f) { return _mm512_mask_blend_epi32(m, f, t); }
+
+        static I cvtt(const F v) { return _mm512_cvttps_epi32(v); }
+        static F cvt(const I v) { return _mm512_cvtepi32_ps(v); }
+        static I bits(const F v) { return _mm512_castps_si512(v); }
+        static F floats(const I v) { return _mm512_castsi512_ps(v); }
+
+        static I addi(const I a, const I b) { return _mm512_add_epi32(a, b); }
+        static I subi(const I a, const I b) { return _mm512_sub_epi32(a, b); }
+        static I andi(const I a, const I b) { return _mm512_and_si512(a, b); }
+        static I ori(const I a, const I b) { return _mm512_or_si512(a, b); }
+        static I xori(const I a, const I b) { return _mm512_xor_si512(a, b); }
+        static I slli(const I a, const int n) { return _mm512_slli_epi32(a, unsigned(n)); }
+        static I srli(const I a, const int n) { return _mm512_srli_epi32(a, unsigned(n)); }
+    };
+}
+
+const PacketKernels& avx512Kernels()
+{
+    static const PacketKernels kernels = PacketKernel::makeKernels<AVX512Lanes>(SimdLevel::AVX512);
+    return kernels;
+}
\ No newline at end of file
@@ -0,0 +1,436 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Constants.h"
+#include "Packet.h"
+
+// DE and rayMarch from res/raytrace.comp written once against a "lane"
+// interface S and instantiated per instruction set in the Packet*.cpp files.
+//
+// S provides F (floats), I (32-bit ints) and M (masks) plus the handful of
+// operations used below. The transcendental functions are the Cephes /
+// sse_mathfun polynomials, evaluated in exactly the same order for every S,
+// so the scalar instantiation produces bit-identical output to the SIMD
+// ones. Don't call std:: math in here, and don't let the compiler contract
+// into FMAs (the Packet*.cpp files are built with -ffp-contract=off)!
+namespace PacketKernel
+{
+    constexpr float PI_F = 3.14159265359f;
+
+    constexpr int32_t SIGN_MASK = int32_t(0x80000000u);
+    constexpr int32_t INV_SIGN_MASK = 0x7fffffff;
+
+    template<class S>
+    typename S::F abs(const typename S::F x)
+    {
+        return S::floats(S::andi(S::bits(x), S::seti(INV_SIGN_MASK)));
+    }
+
+    template<class S>
+    typename S::F floor(const typename S::F x)
+    {
+        const typename S::F t = S::cvt(S::cvtt(x));
+        return S::select(S::gt(t, x), S::sub(t, S::set(1.f)), t);
+    }
+
+    // natural log, x > 0
+    template<class S>
+    typename S::F log(typename S::F x)
+    {
+        using F = typename S::F;
+        using I = typename S::I;
+
+        x = S::max(x, S::floats(S::seti(0x00800000))); // cut off denormals
+
+        I exponent = S::srli(S::bits(x), 23);
+
+        // keep only the fractional part
+        x = S::floats(S::ori(S::andi(S::bits(x), S::seti(~0x7f800000)), S::bits(S::set(0.5f))));
+
+        exponent = S::subi(exponent, S::seti(0x7f));
+        F e = S::add(S::cvt(exponent), S::set(1.f));
+
+        // x < sqrt(1/2) ? e -= 1, x = x + x - 1 : x = x - 1
+        const auto small = S::lt(x, S::set(0.707106781186547524f));
+        const F tmp = S::select(small, x, S::set(0.f));
+        x = S::sub(x, S::set(1.f));
+        e = S::sub(e, S::select(small, S::set(1.f), S::set(0.f)));
+        x = S::add(x, tmp);
+
+        const F z = S::mul(x, x);
+
+        F y = S::set(7.0376836292E-2f);
+        y = S::add(S::mul(y, x), S::set(-1.1514610310E-1f));
+        y = S::add(S::mul(y, x), S::set(1.1676998740E-1f));
+        y = S::add(S::mul(y, x), S::set(-1.2420140846E-1f));
+        y = S::add(S::mul(y, x), S::set(1.4249322787E-1f));
+        y = S::add(S::mul(y, x), S::set(-1.6668057665E-1f));
+        y = S::add(S::mul(y, x), S::set(2.0000714765E-1f));
+        y = S::add(S::mul(y, x), S::set(-2.4999993993E-1f));
+        y = S::add(S::mul(y, x), S::set(3.3333331174E-1f));
+        y = S::mul(S::mul(y, x), z);
+
+        y = S::add(y, S::mul(e, S::set(-2.12194440e-4f)));
+        y = S::sub(y, S::mul(z, S::set(0.5f)));
+        x = S::add(x, y);
+        x = S::add(x, S::mul(e, S::set(0.693359375f)));
+
+        return x;
+    }
+
+    template<class S>
+    typename S::F exp(typename S::F x)
+    {
+        using F = typename S::F;
+        using I = typename S::I;
+
+        x = S::min(x, S::set(88.3762626647949f));
+        x = S::max(x, S::set(-88.3762626647949f));
+
+        // exp(x) = 2^n * exp(g), n = round(x / log(2))
+        F fx = S::add(S::mul(x, S::set(1.44269504088896341f)), S::set(0.5f));
+        fx = floor<S>(fx);
+
+        x = S::sub(x, S::mul(fx, S::set(0.693359375f)));
+        x = S::sub(x, S::mul(fx, S::set(-2.12194440e-4f)));
+
+        const F z = S::mul(x, x);
+
+        F y = S::set(1.9875691500E-4f);
+        y = S::add(S::mul(y, x), S::set(1.3981999507E-3f));
+        y = S::add(S::mul(y, x), S::set(8.3334519073E-3f));
+        y = S::add(S::mul(y, x), S::set(4.1665795894E-2f));
+        y = S::add(S::mul(y, x), S::set(1.6666665459E-1f));
+        y = S::add(S::mul(y, x), S::set(5.0000001201E-1f));
+        y = S::add(S::add(S::mul(y, z), x), S::set(1.f));
+
+        // build 2^n
+        I n = S::cvtt(fx);
+        n = S::addi(n, S::seti(0x7f));
+        n = S::slli(n, 23);
+
+        return S::mul(y, S::floats(n));
+    }
+
+    template<class S>
+    void sinCos(typename S::F x, typename S::F& sin, typename S::F& cos)
+    {
+        using F = typename S::F;
+        using I = typename S::I;
+
+        I signSin = S::andi(S::bits(x), S::seti(SIGN_MASK));
+        x = abs<S>(x);
+
+        // octant, rounded up to an even number
+        I j = S::cvtt(S::mul(x, S::set(1.27323954473516f))); // 4 / PI
+        j = S::addi(j, S::seti(1));
+        j = S::andi(j, S::seti(~1));
+        const F y = S::cvt(j);
+
+        const I swapSignSin = S::slli(S::andi(j, S::seti(4)), 29);
+        const auto polyMask = S::eqi(S::andi(j, S::seti(2)), S::seti(0));
+        const I signCos = S::slli(S::andi(S::xori(S::subi(j, S::seti(2)), S::seti(-1)), S::seti(4)), 29);
+        signSin = S::xori(signSin, swapSignSin);
+
+        // extended precision modular arithmetic
+        x = S::sub(x, S::mul(y, S::set(0.78515625f)));
+        x = S::sub(x, S::mul(y, S::set(2.4187564849853515625e-4f)));
+        x = S::sub(x, S::mul(y, S::set(3.77489497744594108e-8f)));
+
+        const F z = S::mul(x, x);
+
+        // cos polynomial, valid on [0, PI/4]
+        F c = S::set(2.443315711809948E-005f);
+        c = S::add(S::mul(c, z), S::set(-1.388731625493765E-003f));
+        c = S::add(S::mul(c, z), S::set(4.166664568298827E-002f));
+        c = S::mul(S::mul(c, z), z);
+        c = S::sub(c, S::mul(z, S::set(0.5f)));
+        c = S::add(c, S::set(1.f));
+
+        // sin polynomial, valid on [0, PI/4]
+        F s = S::set(-1.9515295891E-4f);
+        s = S::add(S::mul(s, z), S::set(8.3321608736E-3f));
+        s = S::add(S::mul(s, z), S::set(-1.6666654611E-1f));
+        s = S::add(S::mul(S::mul(s, z), x), x);
+
+        sin = S::floats(S::xori(S::bits(S::select(polyMask, s, c)), signSin));
+        cos = S::floats(S::xori(S::bits(S::select(polyMask, c, s)), signCos));
+    }
+
+    // atan2 that returns 0 for (0, 0) rather than NaN
+    template<class S>
+    typename S::F atan2(const typename S::F y, const typename S::F x)
+    {
+        using F = typename S::F;
+
+        const F ax = abs<S>(x);
+        const F ay = abs<S>(y);
+
+        // reduce to atan(a) for a in [0, 1]
+        const F num = S::min(ax, ay);
+        const F den = S::max(ax, ay);
+        F a = S::select(S::gt(den, S::set(0.f)), S::div(num, den), S::set(0.f));
+
+        // and then to [0, tan(PI/8)]
+        const auto big = S::gt(a, S::set(0.4142135623730950f));
+        const F offset = S::select(big, S::set(PI_F / 4.f), S::set(0.f));
+        a = S::select(big, S::div(S::sub(a, S::set(1.f)), S::add(a, S::set(1.f))), a);
+
+        const F z = S::mul(a, a);
+
+        F r = S::set(8.05374449538e-2f);
+        r = S::add(S::mul(r, z), S::set(-1.38776856032E-1f));
+        r = S::add(S::mul(r, z), S::set(1.99777106478E-1f));
+        r = S::add(S::mul(r, z), S::set(-3.33329491539E-1f));
+        r = S::add(S::mul(S::mul(r, z), a), a);
+        r = S::add(offset, r);
+
+        // back to the full circle
+        r = S::select(S::gt(ay, ax), S::sub(S::set(PI_F / 2.f), r), r);
+        r = S::select(S::lt(x, S::set(0.f)), S::sub(S::set(PI_F), r), r);
+
+        return S::floats(S::xori(S::bits(r), S::andi(S::bits(y), S::seti(SIGN_MASK))));
+    }
+
+    template<class S>
+    typename S::F rand(const typename S::F x, const typename S::F y)
+    {
+        using F = typename S::F;
+
+        F sin, cos;
+        sinCos<S>(S::add(S::mul(x, S::set(12.9898f)), S::mul(y, S::set(78.233f))), sin, cos);
+
+        const F v = S::mul(sin, S::set(43758.5453f));
+        return S::sub(v, floor<S>(v));
+    }
+
+    // Mandelbulb distance estimator in polar coordinates, lanes outside of active are left alone
+    template<class S>
+    typename S::F genericDe(const typename S::F px, const typename S::F py, const typename S::F pz, typename S::M active)
+    {
+        using F = typename S::F;
+
+        F zx = px, zy = py, zz = pz;
+        F dr = S::set(1.f);
+        F r = S::set(0.f);
+
+        for (int i = 0; i < ITERATIONS; i++) {
+            const F xy2 = S::add(S::mul(zx, zx), S::mul(zy, zy));
+
+            r = S::select(active, S::sqrt(S::add(xy2, S::mul(zz, zz))), r);
+            active = S::mandnot(active, S::gt(r, S::set(BAILOUT)));
+            if (!S::any(active)) break;
+
+            // convert to polar coordinates, acos(z / r) == atan2(length(xy), z)
+            F theta = atan2<S>(S::sqrt(xy2), zz);
+            F phi = atan2<S>(zy, zx);
+
+            const F logR = log<S>(r);
+            const F newDr = S::add(S::mul(S::mul(exp<S>(S::mul(logR, S::set(POWER - 1.f))), S::set(POWER)), dr), S::set(1.f));
+
+            // scale and rotate the point
+            const F zr = exp<S>(S::mul(logR, S::set(POWER)));
+            theta = S::mul(theta, S::set(POWER));
+            phi = S::mul(phi, S::set(POWER));
+
+            F sinTheta, cosTheta, sinPhi, cosPhi;
+            sinCos<S>(theta, sinTheta, cosTheta);
+            sinCos<S>(phi, sinPhi, cosPhi);
+
+            // convert back to cartesian coordinates
+            dr = S::select(active, newDr, dr);
+            zx = S::select(active, S::add(S::mul(zr, S::mul(sinTheta, cosPhi)), px), zx);
+            zy = S::select(active, S::add(S::mul(zr, S::mul(sinPhi, sinTheta)), py), zy);
+            zz = S::select(active, S::add(S::mul(zr, cosTheta), pz), zz);
+        }
+
+        return S::div(S::mul(S::mul(S::set(0.5f), log<S>(r)), r), dr);
+    }
+
+    // c^N by squaring, from the highest bit down, like complexPower in Fractal.cpp
+    template<class S, int N>
+    void complexPower(typename S::F& re, typename S::F& im)
+    {
+        using F = typename S::F;
+
+        const F cRe = re, cIm = im;
+        for (int bit = highestBit(N) - 1; bit >= 0; bit--) {
+            F nextRe = S::sub(S::mul(re, re), S::mul(im, im));
+            F nextIm = S::mul(S::mul(re, im), S::set(2.f));
+            if ((N >> bit) & 1) {
+                const F squaredRe = nextRe;
+                nextRe = S::sub(S::mul(squaredRe, cRe), S::mul(nextIm, cIm));
+                nextIm = S::add(S::mul(squaredRe, cIm), S::mul(nextIm, cRe));
+            }
+            re = nextRe;
+            im = nextIm;
+        }
+    }
+
+    template<class S, int N>
+    typename S::F realPower(const typename S::F x)
+    {
+        typename S::F result = x;
+        for (int bit = highestBit(N) - 1; bit >= 0; bit--) {
+            result = S::mul(result, result);
+            if ((N >> bit) & 1)
+                result = S::mul(result, x);
+        }
+        return result;
+    }
+
+    // the same for whole number powers without any trig, see Fractal::triplexDE
+    template<class S>
+    typename S::F triplexDe(const typename S::F px, const typename S::F py, const typename S::F pz, typename S::M active)
+    {
+        using F = typename S::F;
+
+        F zx = px, zy = py, zz = pz;
+        F dr = S::set(1.f);
+        F r = S::set(0.f);
+
+        for (int i = 0; i < ITERATIONS; i++) {
+            const F xy2 = S::add(S::mul(zx, zx), S::mul(zy, zy));
+
+            r = S::select(active, S::sqrt(S::add(xy2, S::mul(zz, zz))), r);
+            active = S::mandnot(active, S::gt(r, S::set(BAILOUT)));
+            if (!S::any(active)) break;
+
+            const F newDr = S::add(S::mul(S::mul(realPower<S, INT_POWER - 1>(r), S::set(float(INT_POWER))), dr), S::set(1.f));
+
+            // r^n * (cos(n * theta), sin(n * theta))
+            const F rho = S::sqrt(xy2);
+            F thetaRe = zz, thetaIm = rho;
+            complexPower<S, INT_POWER>(thetaRe, thetaIm);
+
+            // (cos(n * phi), sin(n * phi)), phi is 0 on the z axis
+            const auto onAxis = S::mandnot(S::gt(rho, S::set(0.f)), S::all());
+            const F divisor = S::select(onAxis, S::set(1.f), rho);
+            F phiRe = S::select(onAxis, S::set(1.f), S::div(zx, divisor));
+            F phiIm = S::select(onAxis, S::set(0.f), S::div(zy, divisor));
+            complexPower<S, INT_POWER>(phiRe, phiIm);
+
+            dr = S::select(active, newDr, dr);
+            zx = S::select(active, S::add(S::mul(thetaIm, phiRe), px), zx);
+            zy = S::select(active, S::add(S::mul(thetaIm, phiIm), py), zy);
+            zz = S::select(active, S::add(thetaRe, pz), zz);
+        }
+
+        return S::div(S::mul(S::mul(S::set(0.5f), log<S>(r)), r), dr);
+    }
+
+    // triplexDe if POWER is a whole number, genericDe if not
+    template<class S>
+    typename S::F de(const typename S::F px, const typename S::F py, const typename S::F pz, const typename S::M active)
+    {
+        return INT_POWER != 0 ? triplexDe<S>(px, py, pz, active) : genericDe<S>(px, py, pz, active);
+    }
+
+    template<class S>
+    void deN(const float* x, const float* y, const float* z, float* dist, const int count)
+    {
+        for (int i = 0; i < count; i += S::width) {
+            if (i + S::width <= count) {
+                S::store(dist + i, de<S>(S::load(x + i), S::load(y + i), S::load(z + i), S::all()));
+                continue;
+            }
+
+            // pad the tail with copies of the last point
+            float tx[S::width], ty[S::width], tz[S::width], td[S::width];
+            for (int lane = 0; lane < S::width; lane++) {
+                const int src = (i + lane < count) ? i + lane : count - 1;
+                tx[lane] = x[src];
+                ty[lane] = y[src];
+                tz[lane] = z[src];
+            }
+
+            S::store(td, de<S>(S::load(tx), S::load(ty), S::load(tz), S::all()));
+
+            for (int lane = 0; i + lane < count; lane++)
+                dist[i + lane] = td[lane];
+        }
+    }
+
+    template<class S>
+    void rayMarch(const glm::vec3& origin, const typename S::F dirX, const typename S::F dirY, const typename S::F dirZ,
+                  typename S::F& travelDist, typename S::I& steps, typename S::I& deCalls)
+    {
+        using F = typename S::F;
+        using M = typename S::M;
+
+        F px = S::set(origin.x), py = S::set(origin.y), pz = S::set(origin.z);
+        const F jitter = rand<S>(dirX, dirY);
+
+        M active = S::all();
+        steps = S::seti(0);
+        deCalls = S::seti(0);
+
+        for (bool first = true; S::any(active); first = false) { // march!
+            F dist = de<S>(px, py, pz, active);
+            deCalls = S::selecti(active, S::addi(deCalls, S::seti(1)), deCalls);
+
+            if (first)
+                dist = S::mul(dist, jitter);
+
+            active = S::mandnot(active, S::gt(travelDist, S::set(RENDER_DIST)));
+            active = S::mandnot(active, S::lt(dist, S::set(HIT_DIST)));
+
+            px = S::select(active, S::add(px, S::mul(dirX, dist)), px);
+            py = S::select(active, S::add(py, S::mul(dirY, dist)), py);
+            pz = S::select(active, S::add(pz, S::mul(dirZ, dist)), pz);
+            travelDist = S::select(active, S::add(travelDist, dist), travelDist);
+            steps = S::selecti(active, S::addi(steps, S::seti(1)), steps);
+
+            active = S::mandnot(active, S::gti(steps, S::seti(MAX_STEPS)));
+        }
+    }
+
+    template<class S>
+    void rayMarchN(const glm::vec3& origin, const float* dirX, const float* dirY, const float* dirZ,
+                   float* travelDist, int* steps, int* deCalls, const int count)
+    {
+        typename S::F dist;
+        typename S::I stepCount, deCount;
+
+        for (int i = 0; i < count; i += S::width) {
+            if (i + S::width <= count) {
+                dist = S::load(travelDist + i);
+                rayMarch<S>(origin, S::load(dirX + i), S::load(dirY + i), S::load(dirZ + i), dist, stepCount, deCount);
+                S::store(travelDist + i, dist);
+                S::storei(steps + i, stepCount);
+                S::storei(deCalls + i, deCount);
+                continue;
+            }
+
+            // pad the tail with copies of the last ray
+            float tx[S::width], ty[S::width], tz[S::width], td[S::width];
+            int ts[S::width], tc[S::width];
+            for (int lane = 0; lane < S::width; lane++) {
+                const int src = (i + lane < count) ? i + lane : count - 1;
+                tx[lane] = dirX[src];
+                ty[lane] = dirY[src];
+                tz[lane] = dirZ[src];
+                td[lane] = travelDist[src];
+            }
+
+            dist = S::load(td);
+            rayMarch<S>(origin, S::load(tx), S::load(ty), S::load(tz), dist, stepCount, deCount);
+            S::store(td, dist);
+            S::storei(ts, stepCount);
+            S::storei(tc, deCount);
+
+            for (int lane = 0; i + lane < count; lane++) {
+                travelDist[i + lane] = td[lane];
+                steps[i + lane] = ts[lane];
+                deCalls[i + lane] = tc[lane];
+            }
+        }
+    }
+
+    template<class S>
+    PacketKernels makeKernels(const SimdLevel level)
+    {
+        return PacketKernels{ level, S::width, &deN<S>, &rayMarchN<S> };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include <smmintrin.h>
+
+#include "PacketKernel.h"
+
+// built with -msse4.1 (see CMakeLists.txt), only called after a CPUID check
+namespace
+{
+    struct SSE4Lanes
+    {
+        using F = __m128;
+        using I = __m128i;
+        using M = __m128;
+
+        static constexpr int width = 4;
+
+        static F set(const float v) { return _mm_set1_ps(v); }
+        static I seti(const int32_t v) { return _mm_set1_epi32(v); }
+        static F load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, const F v) { _mm_storeu_ps(p, v); }
+        static void storei(int* p, const I v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+        static F add(const F a, const F b) { return _mm_add_ps(a, b); }
+        static F sub(const F a, const F b) { return _mm_sub_ps(a, b); }
+        static F mul(const F a, const F b) { return _mm_mul_ps(a, b); }
+        static F div(const F a, const F b) { return _mm_div_ps(a, b); }
+        static F sqrt(const F a) { return _mm_sqrt_ps(a); }
+        static F min(const F a, const F b) { return _mm_min_ps(a, b); }
+        static F max(const F a, const F b) { return _mm_max_ps(a, b); }
+
+        static M lt(const F a, const F b) { return _mm_cmplt_ps(a, b); }
+        static M gt(const F a, const F b) { return _mm_cmpgt_ps(a, b); }
+        static M eqi(const I a, const I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+        static M gti(const I a, const I b) { return _mm_castsi128_ps(_mm_cmpgt_epi32(a, b)); }
+
+        static M all() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+        static M mandnot(const M a, const M b) { return _mm_andnot_ps(b, a); }
+        static bool any(const M m) { return _mm_movemask_ps(m) != 0; }
+
+        static F select(const M m, const F t, const F f) { return _mm_blendv_ps(f, t, m); }
+        static I selecti(const M m, const I t, const I f) { return _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(f), _mm_castsi128_ps(t), m)); }
+
+        static I cvtt(const F v) { return _mm_cvttps_epi32(v); }
+        static F cvt(const I v) { return _mm_cvtepi32_ps(v); }
+        static I bits(const F v) { return _mm_castps_si128(v); }
+        static F floats(const I v) { return _mm_castsi128_ps(v); }
+
+        static I addi(const I a, const I b) { return _mm_add_epi32(a, b); }
+        static I subi(const I a, const I b) { return _mm_sub_epi32(a, b); }
+        static I andi(const I a, const I b) { return _mm_and_si128(a, b); }
+        static I ori(const I a, const I b) { return _mm_or_si128(a, b); }
+        static I xori(const I a, const I b) { return _mm_xor_si128(a, b); }
+        static I slli(const I a, const int n) { return _mm_slli_epi32(a, n); }
+        static I srli(const I a, const int n) { return _mm_srli_epi32(a, n); }
+    };
+}
+
+const PacketKernels& sse4Kernels()
+{
+    static const PacketKernels kernels = PacketKernel::makeKernels<SSE4Lanes>(SimdLevel::SSE4);
+    return kernels;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "RenderManifest.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Util.h"
+
+RenderManifest::~RenderManifest()
+{
+    close();
+}
+
+std::string RenderManifest::pathFor(const std::string& imagePath)
+{
+    return imagePath + ".manifest";
+}
+
+int RenderManifest::open(const std::string& path, const std::string& header, const glm::ivec2 tileCount)
+{
+    close();
+
+    this->path = path;
+    this->header = header;
+    this->tileCount = tileCount;
+    samples.assign(size_t(tileCount.x) * tileCount.y, 0);
+
+    std::string contents;
+    {
+        std::ifstream existing(path, std::ios::binary);
+        std::stringstream stream;
+        stream << existing.rdbuf();
+        contents = stream.str();
+    }
+
+    int finished = 0;
+    if (contents.compare(0, header.size(), header) == 0)
+    {
+        // only whole lines, the last one may have been cut off halfway through
+        size_t lineStart = header.size();
+        for (size_t lineEnd; (lineEnd = contents.find('\n', lineStart)) != std::string::npos; lineStart = lineEnd + 1)
+        {
+            int x, y, tileSamples;
+            const std::string line = contents.substr(lineStart, lineEnd - lineStart);
+            if (sscanf(line.c_str(), "tile %d %d %d", &x, &y, &tileSamples) != 3
+                || x < 0 || y < 0 || x >= tileCount.x || y >= tileCount.y || tileSamples <= 0)
+                continue;
+
+            uint16_t& tile = samples[size_t(y) * tileCount.x + x];
+            finished += tile == 0;
+            tile = uint16_t(std::min(tileSamples, 0xFFFF));
+        }
+    }
+    else if (!contents.empty())
+        std::cout << "\"" << path << "\" is from a different render, starting over\n";
+
+    // a clean copy to append to, without the cut off line
+    if (!rewrite())
+        return 0;
+
+    return finished;
+}
+
+bool RenderManifest::restart()
+{
+    std::fill(samples.begin(), samples.end(), uint16_t(0));
+    return rewrite();
+}
+
+int RenderManifest::getSamples(const int x, const int y) const
+{
+    if (x < 0 || y < 0 || x >= tileCount.x || y >= tileCount.y)
+        return 0;
+
+    return samples[size_t(y) * tileCount.x + x];
+}
+
+bool RenderManifest::finish(const int x, const int y, const int tileSamples)
+{
+    if (!file || x < 0 || y < 0 || x >= tileCount.x || y >= tileCount.y)
+        return false;
+
+    samples[size_t(y) * tileCount.x + x] = uint16_t(std::clamp(tileSamples, 1, 0xFFFF));
+
+    fprintf(file, "tile %d %d %d\n", x, y, tileSamples);
+    return syncFile(file);
+}
+
+void RenderManifest::remove()
+{
+    close();
+    std::remove(path.c_str());
+}
+
+void RenderManifest::close()
+{
+    if (file)
+        fclose(file);
+    file = nullptr;
+}
+
+bool RenderManifest::isOpen() const
+{
+    return file != nullptr;
+}
+
+bool RenderManifest::rewrite()
+{
+    close();
+
+    // the old manifest stays whole until the new one is on disk
+    const std::string newPath = path + ".new";
+    FILE* newFile = fopen(newPath.c_str(), "wb");
+    if (!newFile)
+    {
+        std::cout << "Failed to open \"" << newPath << "\" for writing!" << std::endl;
+        return false;
+    }
+
+    fwrite(header.data(), 1, header.size(), newFile);
+    for (int y = 0; y < tileCount.y; y++)
+    {
+        for (int x = 0; x < tileCount.x; x++)
+        {
+            if (const int tileSamples = getSamples(x, y))
+                fprintf(newFile, "tile %d %d %d\n", x, y, tileSamples);
+        }
+    }
+
+    const bool synced = syncFile(newFile);
+    fclose(newFile);
+
+    // rename() only replaces files on POSIX
+    if (!synced || (std::rename(newPath.c_str(), path.c_str()) != 0
+                    && (std::remove(path.c_str()) != 0 || std::rename(newPath.c_str(), path.c_str()) != 0)))
+    {
+        std::cout << "Failed to write \"" << path << "\"!" << std::endl;
+        return false;
+    }
+
+    file = fopen(path.c_str(), "ab");
+    return file != nullptr;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Which tiles of a --tiled render are safely on disk, and with how many samples, in a
+// text file next to the image. Each finished tile appends a line and syncs it, so after
+// a crash or kill the manifest never lists a tile that didn't make it. The header
+// describes everything that decides what the image looks like, and a manifest whose
+// header doesn't match the render being started is ignored.
+class RenderManifest
+{
+public:
+    RenderManifest() = default;
+    ~RenderManifest();
+
+    RenderManifest(const RenderManifest&) = delete;
+    RenderManifest& operator=(const RenderManifest&) = delete;
+
+    // for writing the image at imagePath
+    static std::string pathFor(const std::string& imagePath);
+
+    // Picks up the tiles in the manifest at path if its header matches, or else starts
+    // a new one. Returns how many tiles it already had
+    int open(const std::string& path, const std::string& header, glm::ivec2 tileCount);
+
+    // forgets every tile, for when the image they're in is gone
+    bool restart();
+
+    // how many samples tile (x, y) was finished with, 0 if it wasn't
+    int getSamples(int x, int y) const;
+
+    // call once the tile's pixels are synced to disk, false if the manifest couldn't be
+    bool finish(int x, int y, int samples);
+
+    // closes and deletes it, the render is complete
+    void remove();
+
+    void close();
+
+    bool isOpen() const;
+
+private:
+    // the header and every finished tile, into a new file that replaces the old one
+    bool rewrite();
+
+    FILE* file = nullptr;
+    std::string path;
+    std::string header;
+    glm::ivec2 tileCount{ 0 };
+    std::vector<uint16_t> samples;
+};
@@ -1,4 +1,5 @@
 #include "Shader.h"
+#include "ShaderCache.h"
 
 #include <cstring>
 #include <fstream>
@@ -10,6 +11,8 @@
 
 Shader::Shader(std::string vertexName, std::string fragmentName)
 {
+    const std::string cacheName = vertexName + "-" + fragmentName;
+
     vertexName = "res/" + vertexName + ".vert";
     fragmentName = "res/" + fragmentName + ".frag";
 
@@ -41,6 +44,11 @@ Shader::Shader(std::string vertexName, std::string fragmentName)
         return;
     }
 
+    const uint64_t cacheKey = ShaderCache::key(vertexCode + '\0' + fragmentCode);
+    ID = ShaderCache::load(cacheName, cacheKey);
+    if (ID != 0)
+        return;
+
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
@@ -83,6 +91,7 @@ Shader::Shader(std::string vertexName, std::string fragmentName)
     glAttachShader(ID, vertex);
     glAttachShader(ID, fragment);
 
+    ShaderCache::prepare(ID);
     glLinkProgram(ID);
     
     // catch linking errors
@@ -97,10 +106,14 @@ Shader::Shader(std::string vertexName, std::string fragmentName)
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    ShaderCache::save(cacheName, cacheKey, ID);
 }
 
 Shader::Shader(std::string computeName, HasExtra hasExtra, const char* extraCode)
 {
+    const std::string cacheName = computeName;
+
     computeName = "res/" + computeName + ".comp";
 
     std::string computeCode;
@@ -126,6 +139,12 @@ Shader::Shader(std::string computeName, HasExtra hasExtra, const char* extraCode
     if(hasExtra == HasExtra::Yes)
         computeCode.insert(strlen("#version 430\n"), extraCode);
 
+    // after splicing in extraCode, so every set of defines gets its own binary
+    const uint64_t cacheKey = ShaderCache::key(computeCode);
+    ID = ShaderCache::load(cacheName, cacheKey);
+    if (ID != 0)
+        return;
+
     const GLuint computeShader = glCreateShader(GL_COMPUTE_SHADER);
 
     char const* computeSource = computeCode.c_str();
@@ -147,6 +166,7 @@ Shader::Shader(std::string computeName, HasExtra hasExtra, const char* extraCode
     // link the program
     ID = glCreateProgram();
     glAttachShader(ID, computeShader);
+    ShaderCache::prepare(ID);
     glLinkProgram(ID);
 
     // catch errors
@@ -160,6 +180,8 @@ Shader::Shader(std::string computeName, HasExtra hasExtra, const char* extraCode
 
     glDetachShader(ID, computeShader);
     glDeleteShader(computeShader);
+
+    ShaderCache::save(cacheName, cacheKey, ID);
 }
 
 Shader::Shader(HasExtra, const std::string source)
@@ -200,6 +222,8 @@ Shader::Shader(HasExtra, const std::string source)
     glDeleteShader(computeShader);
 }
 
+Shader::Shader(const GLuint program) : ID(program) {}
+
 // use/activate the shader
 void Shader::use() const {
     glUseProgram(ID);
@@ -20,6 +20,9 @@ public:
 
     Shader(HasExtra, std::string source);
 
+    // takes over an already linked program
+    explicit Shader(GLuint program);
+
     void use() const;
 
     // utility uniform functions
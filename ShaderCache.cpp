@@ -0,0 +1,249 @@
+#include "ShaderCache.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+
+constexpr char CACHE_DIR[] = "shadercache";
+
+constexpr char MAGIC[4] = { 'F', '4', 'D', 'P' };
+constexpr uint32_t VERSION = 1;
+
+// binaries kept per shader, each set of defines and each driver gets its own
+constexpr size_t MAX_BINARIES = 32;
+
+namespace
+{
+    bool enabled = true;
+
+    // FNV-1a, unlike std::hash it's the same on every compiler
+    uint64_t fnv1a(uint64_t seed, const char* data, const size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            seed ^= uint8_t(data[i]);
+            seed *= 0x100000001B3ull;
+        }
+        return seed;
+    }
+
+    uint64_t fnv1a(const uint64_t seed, const char* str)
+    {
+        // nullptr if there's no context, which only happens if something's very wrong
+        return str ? fnv1a(seed, str, strlen(str) + 1) : seed;
+    }
+
+    std::string cachePath(const std::string& name, const uint64_t key)
+    {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key);
+        return std::string(CACHE_DIR) + "/" + name + "-" + hex + ".bin";
+    }
+
+    // every binary of the shader called name, with when it was last used
+    std::vector<std::pair<time_t, std::string>> listBinaries(const std::string& name)
+    {
+        std::vector<std::pair<time_t, std::string>> binaries;
+        const std::string prefix = name + "-";
+        const auto matches = [&](const std::string& file) {
+            return file.size() == prefix.size() + 20 && file.compare(0, prefix.size(), prefix) == 0
+                && file.compare(file.size() - 4, 4, ".bin") == 0;
+        };
+
+#ifdef _WIN32
+        _finddata_t found;
+        const intptr_t search = _findfirst((std::string(CACHE_DIR) + "/" + prefix + "*.bin").c_str(), &found);
+        if (search == -1)
+            return binaries;
+
+        do
+        {
+            if (matches(found.name))
+                binaries.emplace_back(found.time_write, std::string(CACHE_DIR) + "/" + found.name);
+        } while (_findnext(search, &found) == 0);
+        _findclose(search);
+#else
+        DIR* dir = opendir(CACHE_DIR);
+        if (!dir)
+            return binaries;
+
+        while (const dirent* entry = readdir(dir))
+        {
+            const std::string path = std::string(CACHE_DIR) + "/" + entry->d_name;
+            struct stat info;
+            if (matches(entry->d_name) && stat(path.c_str(), &info) == 0)
+                binaries.emplace_back(info.st_mtime, path);
+        }
+        closedir(dir);
+#endif
+
+        return binaries;
+    }
+
+    // drop the least recently used binaries of name past MAX_BINARIES, so switching
+    // formulas, settings and drivers doesn't grow the cache forever
+    void evict(const std::string& name)
+    {
+        auto binaries = listBinaries(name);
+        if (binaries.size() <= MAX_BINARIES)
+            return;
+
+        std::sort(binaries.begin(), binaries.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (size_t i = MAX_BINARIES; i < binaries.size(); i++)
+            remove(binaries[i].second.c_str());
+    }
+
+    bool supported()
+    {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return enabled && formats > 0;
+    }
+}
+
+void ShaderCache::setEnabled(const bool enable)
+{
+    enabled = enable;
+}
+
+uint64_t ShaderCache::hash(const std::string& data)
+{
+    return fnv1a(0xCBF29CE484222325ull, data.c_str(), data.size());
+}
+
+uint64_t ShaderCache::key(const std::string& source)
+{
+    uint64_t key = hash(source);
+    key = fnv1a(key, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    key = fnv1a(key, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    key = fnv1a(key, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    return key;
+}
+
+GLuint ShaderCache::load(const std::string& name, const uint64_t key)
+{
+    if (!supported())
+        return 0;
+
+    const std::string path = cachePath(name, key);
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return 0;
+
+    char magic[4];
+    uint32_t version = 0, length = 0;
+    uint64_t fileKey = 0;
+    GLenum format = 0;
+
+    const bool headerOk = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+        && fread(&version, sizeof(version), 1, file) == 1 && version == VERSION
+        && fread(&fileKey, sizeof(fileKey), 1, file) == 1 && fileKey == key
+        && fread(&format, sizeof(format), 1, file) == 1
+        && fread(&length, sizeof(length), 1, file) == 1 && length > 0;
+
+    std::vector<char> binary(headerOk ? length : 0);
+    const bool readOk = headerOk && fread(binary.data(), 1, length, file) == length;
+    fclose(file);
+
+    if (!readOk)
+    {
+        std::cout << "Shader cache file \"" << path << "\" is broken, recompiling.\n";
+        remove(path.c_str());
+        return 0;
+    }
+
+    const GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), GLsizei(length));
+
+    // drivers reject binaries from other driver builds even when the version string matches
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        std::cout << "Driver rejected cached shader \"" << path << "\", recompiling.\n";
+        glDeleteProgram(program);
+        remove(path.c_str());
+        return 0;
+    }
+
+    // mark it used, evict() goes by modification time
+#ifdef _WIN32
+    _utime(path.c_str(), nullptr);
+#else
+    utime(path.c_str(), nullptr);
+#endif
+
+    return program;
+}
+
+void ShaderCache::prepare(const GLuint program)
+{
+    if (enabled)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ShaderCache::save(const std::string& name, const uint64_t key, const GLuint program)
+{
+    if (!supported())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+#ifdef _WIN32
+    _mkdir(CACHE_DIR);
+#else
+    mkdir(CACHE_DIR, 0755);
+#endif
+
+    // write then rename, so a crash can't leave half a binary behind
+    const std::string path = cachePath(name, key);
+    const std::string tempPath = path + ".tmp";
+
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+        return;
+
+    const uint32_t length32 = uint32_t(length);
+    const bool ok = fwrite(MAGIC, sizeof(MAGIC), 1, file) == 1
+        && fwrite(&VERSION, sizeof(VERSION), 1, file) == 1
+        && fwrite(&key, sizeof(key), 1, file) == 1
+        && fwrite(&format, sizeof(format), 1, file) == 1
+        && fwrite(&length32, sizeof(length32), 1, file) == 1
+        && fwrite(binary.data(), 1, binary.size(), file) == binary.size();
+
+    if (fclose(file) != 0 || !ok)
+    {
+        remove(tempPath.c_str());
+        return;
+    }
+
+    remove(path.c_str());
+    if (rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tempPath.c_str());
+        return;
+    }
+
+    evict(name);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glad/glad.h>
+
+// Linked program binaries on disk (in shadercache/ next to res/), so we only
+// pay for compiling a shader once per driver. The key hashes the full source
+// with every define spliced in, plus the driver's vendor, renderer and version,
+// so editing a shader or updating the driver just misses the cache. Past 32
+// binaries of one shader the least recently used are deleted.
+namespace ShaderCache
+{
+    void setEnabled(bool enabled);
+
+    // of the bytes alone, the same on every compiler and driver
+    uint64_t hash(const std::string& data);
+
+    // hash() with the driver in it, needs a current OpenGL context
+    uint64_t key(const std::string& source);
+
+    // a linked program, or 0 if there's no binary or the driver rejected it
+    GLuint load(const std::string& name, uint64_t key);
+
+    // call before linking a program that will be saved
+    void prepare(GLuint program);
+
+    void save(const std::string& name, uint64_t key, GLuint program);
+}
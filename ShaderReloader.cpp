@@ -0,0 +1,455 @@
+#include "ShaderReloader.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+#include "ShaderCache.h"
+
+// from GL_KHR_parallel_shader_compile, which our glad doesn't have
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// how often to look at the files, in seconds
+constexpr double CHECK_INTERVAL = 0.25;
+
+namespace
+{
+    bool hasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+            if (extension && strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool fileStamp(const std::string& path, time_t& modified, long long& size)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return false;
+
+        modified = info.st_mtime;
+        size = (long long)info.st_size;
+        return true;
+    }
+
+    const char* stageName(const GLenum type)
+    {
+        switch (type)
+        {
+        case GL_VERTEX_SHADER: return "vertex";
+        case GL_FRAGMENT_SHADER: return "fragment";
+        case GL_COMPUTE_SHADER: return "compute";
+        default: return "unknown";
+        }
+    }
+
+    std::string cacheSource(const std::vector<std::string>& sources)
+    {
+        // the same key Shader's constructors use
+        std::string joined;
+        for (size_t i = 0; i < sources.size(); i++)
+        {
+            if (i > 0)
+                joined += '\0';
+            joined += sources[i];
+        }
+        return joined;
+    }
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    destroy();
+}
+
+void ShaderReloader::init(GLFWwindow* window)
+{
+    const char* extension = hasExtension("GL_KHR_parallel_shader_compile") ? "glMaxShaderCompilerThreadsKHR"
+                          : hasExtension("GL_ARB_parallel_shader_compile") ? "glMaxShaderCompilerThreadsARB" : nullptr;
+
+    const auto maxShaderCompilerThreads = extension
+        ? reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress(extension)) : nullptr;
+
+    if (maxShaderCompilerThreads)
+    {
+        maxShaderCompilerThreads(0xFFFFFFFF); // as many as the driver likes
+        mode = Mode::ParallelCompile;
+        return;
+    }
+
+    // a hidden window whose context shares objects with ours
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    workerWindow = glfwCreateWindow(1, 1, "Fractal4D shader compiler", nullptr, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+    if (workerWindow)
+    {
+        mode = Mode::SharedContext;
+        worker = std::thread(&ShaderReloader::workerLoop, this);
+        return;
+    }
+
+    mode = Mode::Synchronous;
+}
+
+void ShaderReloader::destroy()
+{
+    if (worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    if (workerWindow)
+        glfwDestroyWindow(workerWindow);
+    workerWindow = nullptr;
+
+    for (Build& build : pending)
+    {
+        for (const GLuint shader : build.shaders)
+            glDeleteShader(shader);
+        glDeleteProgram(build.program);
+    }
+    pending.clear();
+
+    for (Build& build : finished)
+        glDeleteProgram(build.program);
+    finished.clear();
+    jobs.clear();
+}
+
+void ShaderReloader::watch(Shader& shader, const std::string& vertexName, const std::string& fragmentName)
+{
+    Watched watched{ &shader, vertexName + "-" + fragmentName, {}, "" };
+    watched.stages.push_back({ GL_VERTEX_SHADER, "res/" + vertexName + ".vert", 0, 0 });
+    watched.stages.push_back({ GL_FRAGMENT_SHADER, "res/" + fragmentName + ".frag", 0, 0 });
+
+    changed(watched); // remember how the files look now
+    watchedShaders.push_back(watched);
+}
+
+void ShaderReloader::watch(Shader& shader, const std::string& computeName, const HasExtra hasExtra, const std::string& extraCode)
+{
+    Watched watched{ &shader, computeName, {}, hasExtra == HasExtra::Yes ? extraCode : "" };
+    watched.stages.push_back({ GL_COMPUTE_SHADER, "res/" + computeName + ".comp", 0, 0 });
+
+    changed(watched);
+    watchedShaders.push_back(watched);
+}
+
+void ShaderReloader::build(Shader& shader, const std::string& computeName, const HasExtra hasExtra, const std::string& extraCode)
+{
+    watch(shader, computeName, hasExtra, extraCode);
+
+    Build build;
+    build.watched = watchedShaders.size() - 1;
+    if (!readSources(watchedShaders.back(), build))
+    {
+        std::cout << "Failed to read shader \"" << computeName << "\"!\n";
+        return;
+    }
+
+    // loading a binary takes no time at all
+    const GLuint cached = ShaderCache::load(computeName, ShaderCache::key(cacheSource(build.sources)));
+    if (cached != 0)
+    {
+        glDeleteProgram(shader.ID);
+        shader = Shader(cached);
+        return;
+    }
+
+    std::cout << "Building shader \"" << computeName << "\"...\n";
+    submit(build);
+}
+
+bool ShaderReloader::update()
+{
+    bool swapped = false;
+
+    const double now = glfwGetTime();
+    if (now - lastCheck >= CHECK_INTERVAL)
+    {
+        lastCheck = now;
+
+        for (size_t i = 0; i < watchedShaders.size(); i++)
+        {
+            if (!changed(watchedShaders[i]))
+                continue;
+
+            Build build;
+            build.watched = i;
+            if (!readSources(watchedShaders[i], build))
+            {
+                // probably caught the editor halfway through saving, try again next time
+                for (Stage& stage : watchedShaders[i].stages)
+                    stage.modified = 0;
+                continue;
+            }
+
+            std::cout << "Reloading shader \"" << watchedShaders[i].name << "\"...\n";
+
+            swapped |= submit(build);
+        }
+    }
+
+    if (mode == Mode::ParallelCompile)
+    {
+        for (auto it = pending.begin(); it != pending.end();)
+        {
+            if (!isBuilt(*it))
+            {
+                ++it;
+                continue;
+            }
+
+            finishBuild(*it);
+            swapped |= swap(*it);
+            it = pending.erase(it);
+        }
+    }
+    else if (mode == Mode::SharedContext)
+    {
+        std::deque<Build> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(finished);
+        }
+
+        for (Build& build : done)
+            swapped |= swap(build);
+    }
+
+    return swapped;
+}
+
+ShaderReloader::Mode ShaderReloader::getMode() const
+{
+    return mode;
+}
+
+const char* ShaderReloader::getModeName() const
+{
+    switch (mode)
+    {
+    case Mode::ParallelCompile: return "parallel shader compile";
+    case Mode::SharedContext: return "shared context";
+    default: return "synchronous";
+    }
+}
+
+bool ShaderReloader::changed(Watched& watched)
+{
+    bool anyChanged = false;
+    for (Stage& stage : watched.stages)
+    {
+        time_t modified;
+        long long size;
+        if (!fileStamp(stage.path, modified, size))
+            continue; // deleted or being replaced, wait for it to come back
+
+        if (modified != stage.modified || size != stage.size)
+            anyChanged = true;
+
+        stage.modified = modified;
+        stage.size = size;
+    }
+    return anyChanged;
+}
+
+bool ShaderReloader::readSources(const Watched& watched, Build& build) const
+{
+    for (const Stage& stage : watched.stages)
+    {
+        std::ifstream file(stage.path);
+        if (!file)
+            return false;
+
+        std::stringstream stream;
+        stream << file.rdbuf();
+        std::string source = stream.str();
+        if (source.empty())
+            return false;
+
+        if (build.sources.empty() && !watched.extraCode.empty())
+        {
+            // same place Shader puts it, right after the #version line
+            const size_t lineEnd = source.find('\n');
+            source.insert(lineEnd == std::string::npos ? source.size() : lineEnd + 1, watched.extraCode);
+        }
+
+        build.sources.push_back(source);
+        build.types.push_back(stage.type);
+    }
+
+    return true;
+}
+
+void ShaderReloader::startBuild(Build& build) const
+{
+    build.program = glCreateProgram();
+
+    for (size_t i = 0; i < build.sources.size(); i++)
+    {
+        const GLuint shader = glCreateShader(build.types[i]);
+        const char* source = build.sources[i].c_str();
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        glAttachShader(build.program, shader);
+        build.shaders.push_back(shader);
+    }
+
+    // with parallel compile this returns right away, and so does linking
+    ShaderCache::prepare(build.program);
+    glLinkProgram(build.program);
+}
+
+bool ShaderReloader::isBuilt(const Build& build) const
+{
+    GLint done = GL_TRUE;
+    glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+void ShaderReloader::finishBuild(Build& build) const
+{
+    const std::string& name = watchedShaders[build.watched].name;
+
+    int success;
+    char infoLog[512];
+
+    build.ok = true;
+    for (size_t i = 0; i < build.shaders.size(); i++)
+    {
+        glGetShaderiv(build.shaders[i], GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(build.shaders[i], 512, nullptr, infoLog);
+            std::cout << "Failed to compile " << stageName(build.types[i]) << " shader \"" << name << "\", keeping the old one. Error log:\n" << infoLog << std::endl;
+            build.ok = false;
+        }
+    }
+
+    if (build.ok)
+    {
+        glGetProgramiv(build.program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(build.program, 512, nullptr, infoLog);
+            std::cout << "Failed to link shader \"" << name << "\", keeping the old one. Error log:\n" << infoLog << std::endl;
+            build.ok = false;
+        }
+    }
+
+    for (const GLuint shader : build.shaders)
+    {
+        glDetachShader(build.program, shader);
+        glDeleteShader(shader);
+    }
+    build.shaders.clear();
+
+    if (!build.ok)
+    {
+        glDeleteProgram(build.program);
+        build.program = 0;
+        return;
+    }
+
+    ShaderCache::save(name, ShaderCache::key(cacheSource(build.sources)), build.program);
+}
+
+bool ShaderReloader::submit(Build& build)
+{
+    switch (mode)
+    {
+    case Mode::Synchronous:
+        startBuild(build);
+        finishBuild(build);
+        return swap(build);
+    case Mode::ParallelCompile:
+        // a newer edit makes older builds of the same shader pointless
+        for (auto it = pending.begin(); it != pending.end();)
+        {
+            if (it->watched != build.watched)
+            {
+                ++it;
+                continue;
+            }
+            for (const GLuint shader : it->shaders)
+                glDeleteShader(shader);
+            glDeleteProgram(it->program);
+            it = pending.erase(it);
+        }
+
+        startBuild(build);
+        pending.push_back(std::move(build));
+        return false;
+    case Mode::SharedContext:
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(build));
+        }
+        wake.notify_one();
+        return false;
+    }
+
+    return false;
+}
+
+bool ShaderReloader::swap(Build& build)
+{
+    if (!build.ok)
+        return false;
+
+    Shader& shader = *watchedShaders[build.watched].shader;
+    glDeleteProgram(shader.ID);
+    shader = Shader(build.program);
+    build.program = 0;
+
+    std::cout << "Reloaded shader \"" << watchedShaders[build.watched].name << "\"\n";
+    return true;
+}
+
+void ShaderReloader::workerLoop()
+{
+    glfwMakeContextCurrent(workerWindow);
+
+    while (true)
+    {
+        Build build;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping)
+                break;
+
+            build = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        startBuild(build);
+        finishBuild(build);
+
+        // the program has to be complete before the other context touches it
+        glFinish();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back(std::move(build));
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Shader.h"
+
+// Watches the files in res/ behind some Shaders and rebuilds them when they're
+// saved, without freezing the window. The old program keeps rendering until
+// the new one has linked, then update() swaps it in between frames. A shader
+// that fails to compile just prints its log and leaves the old one running.
+//
+// Builds run on the driver's own threads with GL_KHR_parallel_shader_compile,
+// or else on a worker thread with a hidden window sharing our context, or, if
+// even that fails, right there in update().
+class ShaderReloader
+{
+public:
+    enum class Mode { Synchronous, ParallelCompile, SharedContext };
+
+    ShaderReloader() = default;
+    ~ShaderReloader();
+
+    ShaderReloader(const ShaderReloader&) = delete;
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    // window's context must be current on this thread
+    void init(GLFWwindow* window);
+
+    // stops the worker, call before destroying the window
+    void destroy();
+
+    // shader must outlive the reloader
+    void watch(Shader& shader, const std::string& vertexName, const std::string& fragmentName);
+    void watch(Shader& shader, const std::string& computeName, HasExtra hasExtra, const std::string& extraCode);
+
+    // Watches it and builds it for the first time the same way, for shaders that aren't
+    // needed yet. A cached binary goes straight into shader, otherwise shader.ID stays
+    // 0 until update() swaps the new program in
+    void build(Shader& shader, const std::string& computeName, HasExtra hasExtra, const std::string& extraCode);
+
+    // call once per frame, returns true if it swapped in a new program
+    bool update();
+
+    Mode getMode() const;
+    const char* getModeName() const;
+
+private:
+    struct Stage
+    {
+        GLenum type;
+        std::string path;
+        time_t modified;
+        long long size;
+    };
+
+    struct Watched
+    {
+        Shader* shader;
+        std::string name;
+        std::vector<Stage> stages;
+        std::string extraCode; // spliced in after the #version line of the first stage
+    };
+
+    // a program being built
+    struct Build
+    {
+        size_t watched;
+        std::vector<std::string> sources;
+        std::vector<GLenum> types;
+
+        std::vector<GLuint> shaders;
+        GLuint program = 0;
+        bool ok = false; // once finished
+    };
+
+    bool changed(Watched& watched);
+    bool readSources(const Watched& watched, Build& build) const;
+
+    void startBuild(Build& build) const;
+    bool isBuilt(const Build& build) const;
+    void finishBuild(Build& build) const;
+
+    // starts building it however mode says, returns true if that already swapped it in
+    bool submit(Build& build);
+    bool swap(Build& build);
+
+    void workerLoop();
+
+    Mode mode = Mode::Synchronous;
+
+    std::vector<Watched> watchedShaders;
+    std::vector<Build> pending; // ParallelCompile builds on this thread
+    double lastCheck = 0;
+
+    // SharedContext
+    GLFWwindow* workerWindow = nullptr;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Build> jobs;
+    std::deque<Build> finished;
+    bool stopping = false;
+};
@@ -0,0 +1,167 @@
+#include "TileScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    // spreads the low 16 bits of v out to the even bits
+    uint32_t spreadBits(uint32_t v)
+    {
+        v &= 0x0000ffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    }
+
+    uint32_t mortonCode(const int x, const int y)
+    {
+        return spreadBits(uint32_t(x)) | (spreadBits(uint32_t(y)) << 1);
+    }
+
+    float millisecondsBetween(const std::chrono::steady_clock::time_point start, const std::chrono::steady_clock::time_point end)
+    {
+        return std::chrono::duration<float, std::milli>(end - start).count();
+    }
+}
+
+TileScheduler::TileScheduler(const glm::ivec2& imageSize, int tileSize, const unsigned threadCount)
+{
+    tileSize = std::max(1, tileSize);
+
+    const int tilesX = (imageSize.x + tileSize - 1) / tileSize;
+    const int tilesY = (imageSize.y + tileSize - 1) / tileSize;
+
+    std::vector<std::pair<uint32_t, Tile>> ordered;
+    ordered.reserve(size_t(tilesX) * tilesY);
+
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            Tile tile;
+            tile.x = tx * tileSize;
+            tile.y = ty * tileSize;
+            tile.width = std::min(tileSize, imageSize.x - tile.x);
+            tile.height = std::min(tileSize, imageSize.y - tile.y);
+
+            ordered.emplace_back(mortonCode(tx, ty), tile);
+        }
+    }
+
+    std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    tiles.reserve(ordered.size());
+    for (const auto& entry : ordered)
+        tiles.push_back(entry.second);
+
+    for (unsigned i = 0; i < std::max(1u, threadCount); i++)
+        queues.push_back(std::make_unique<TileQueue>());
+
+    threadTimes.resize(queues.size());
+}
+
+void TileScheduler::run(const std::function<void(const Tile&, unsigned)>& work)
+{
+    const unsigned threadCount = unsigned(queues.size());
+
+    // hand out contiguous Morton runs so each thread starts on a compact patch of the image
+    for (unsigned i = 0; i < threadCount; i++) {
+        const size_t first = tiles.size() * i / threadCount;
+        const size_t last = tiles.size() * (i + 1) / threadCount;
+
+        queues[i]->tiles.assign(tiles.begin() + first, tiles.begin() + last);
+        threadTimes[i] = ThreadTimes();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&](const unsigned thread) {
+        ThreadTimes& times = threadTimes[thread];
+        Tile tile;
+
+        while (popOwn(thread, tile) || steal(thread, tile)) {
+            const auto tileStart = std::chrono::steady_clock::now();
+            work(tile, thread);
+            times.busyMilliseconds += millisecondsBetween(tileStart, std::chrono::steady_clock::now());
+            times.tiles++;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned i = 1; i < threadCount; i++)
+        threads.emplace_back(worker, i);
+
+    worker(0); // this thread helps too
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    // anything that wasn't work, including waiting for the slowest thread, counts as idle
+    const auto end = std::chrono::steady_clock::now();
+    const float total = millisecondsBetween(start, end);
+    for (ThreadTimes& times : threadTimes)
+        times.idleMilliseconds = std::max(0.f, total - times.busyMilliseconds);
+}
+
+const std::vector<ThreadTimes>& TileScheduler::getThreadTimes() const
+{
+    return threadTimes;
+}
+
+size_t TileScheduler::getTileCount() const
+{
+    return tiles.size();
+}
+
+bool TileScheduler::popOwn(const unsigned thread, Tile& tile)
+{
+    TileQueue& queue = *queues[thread];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tiles.empty())
+        return false;
+
+    // the owner works front to back...
+    tile = queue.tiles.front();
+    queue.tiles.pop_front();
+    return true;
+}
+
+bool TileScheduler::steal(const unsigned thief, Tile& tile)
+{
+    const unsigned threadCount = unsigned(queues.size());
+
+    for (unsigned offset = 1; offset < threadCount; offset++) {
+        TileQueue& victim = *queues[(thief + offset) % threadCount];
+
+        std::vector<Tile> loot;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+
+            // ...and thieves take the back half, which the owner would have reached last
+            const size_t count = (victim.tiles.size() + 1) / 2;
+            if (count == 0)
+                continue;
+
+            loot.assign(victim.tiles.end() - count, victim.tiles.end());
+            victim.tiles.erase(victim.tiles.end() - count, victim.tiles.end());
+        }
+
+        tile = loot.front();
+
+        TileQueue& own = *queues[thief];
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.tiles.insert(own.tiles.end(), loot.begin() + 1, loot.end());
+        }
+
+        threadTimes[thief].stolenTiles += uint32_t(loot.size());
+        return true;
+    }
+
+    // all tiles are queued up front, so empty queues everywhere means we're done
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct Tile
+{
+    int x, y;
+    int width, height;
+};
+
+struct ThreadTimes
+{
+    float busyMilliseconds = 0; // inside the work function
+    float idleMilliseconds = 0; // looking for work or waiting for the others to finish
+    uint32_t tiles = 0;
+    uint32_t stolenTiles = 0;
+};
+
+// Splits an image into tiles and runs them on a pool of threads. Every thread
+// starts with its own Morton-ordered run of tiles, and once that's used up it
+// steals half of someone else's remaining run, so threads stuck on expensive
+// tiles near the fractal don't leave the others waiting.
+class TileScheduler
+{
+public:
+    TileScheduler(const glm::ivec2& imageSize, int tileSize, unsigned threadCount);
+
+    // calls work(tile, threadIndex) for every tile and returns once they're all done
+    void run(const std::function<void(const Tile&, unsigned)>& work);
+
+    // timings from the last run(), one per thread
+    const std::vector<ThreadTimes>& getThreadTimes() const;
+
+    size_t getTileCount() const;
+
+private:
+    struct TileQueue
+    {
+        std::mutex mutex;
+        std::deque<Tile> tiles;
+    };
+
+    bool popOwn(unsigned thread, Tile& tile);
+    bool steal(unsigned thief, Tile& tile);
+
+    std::vector<Tile> tiles; // in Morton order
+    std::vector<std::unique_ptr<TileQueue>> queues;
+    std::vector<ThreadTimes> threadTimes;
+};
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "TiledTiff.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Util.h"
+
+namespace
+{
+    constexpr uint16_t TYPE_SHORT = 3;
+    constexpr uint16_t TYPE_LONG = 4;
+    constexpr uint16_t TYPE_LONG8 = 16;
+
+    constexpr uint16_t ENTRY_COUNT = 11;
+
+    // little endian, whatever the machine is
+    struct ByteWriter
+    {
+        std::vector<uint8_t> bytes;
+
+        void put(const uint64_t value, const int size)
+        {
+            for (int i = 0; i < size; i++)
+                bytes.push_back(uint8_t(value >> (i * 8)));
+        }
+    };
+
+    bool seek(FILE* file, const uint64_t offset)
+    {
+#ifdef _WIN32
+        return _fseeki64(file, int64_t(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    // leaves the file at its start
+    uint64_t fileLength(FILE* file)
+    {
+#ifdef _WIN32
+        const uint64_t length = _fseeki64(file, 0, SEEK_END) == 0 ? uint64_t(_ftelli64(file)) : 0;
+#else
+        const uint64_t length = fseeko(file, 0, SEEK_END) == 0 ? uint64_t(ftello(file)) : 0;
+#endif
+        return seek(file, 0) ? length : 0;
+    }
+}
+
+TiledTiff::~TiledTiff()
+{
+    close();
+}
+
+bool TiledTiff::open(const std::string& path, const glm::ivec2 imageSize, const int tileSize, const bool keepTiles)
+{
+    close();
+
+    if (tileSize <= 0 || tileSize % 16 != 0 || imageSize.x <= 0 || imageSize.y <= 0)
+        return false;
+
+    this->imageSize = imageSize;
+    this->tileSize = tileSize;
+    tileCount = (imageSize + tileSize - 1) / tileSize;
+
+    const uint64_t tiles = uint64_t(tileCount.x) * uint64_t(tileCount.y);
+    const uint64_t bytesPerTile = uint64_t(tileSize) * uint64_t(tileSize) * 3;
+
+    // Header, then the one IFD, then whatever of its values don't fit in an entry, then
+    // the tiles. Classic TIFF only has 32 bit offsets
+    const auto layout = [&](const bool big, uint64_t& bitsOffset, uint64_t& offsetsOffset, uint64_t& countsOffset) {
+        const uint64_t headerSize = big ? 16 : 8;
+        const uint64_t entrySize = big ? 20 : 12;
+        const uint64_t fieldSize = big ? 8 : 4;
+        const uint64_t ifdSize = (big ? 8 : 2) + ENTRY_COUNT * entrySize + fieldSize;
+
+        uint64_t end = headerSize + ifdSize;
+        bitsOffset = 3 * 2 > fieldSize ? end : 0;
+        end += bitsOffset ? 3 * 2 : 0;
+
+        const uint64_t arraySize = tiles * fieldSize;
+        offsetsOffset = arraySize > fieldSize ? end : 0;
+        end += offsetsOffset ? arraySize : 0;
+        countsOffset = arraySize > fieldSize ? end : 0;
+        end += countsOffset ? arraySize : 0;
+
+        return (end + 15) / 16 * 16;
+    };
+
+    uint64_t bitsOffset, offsetsOffset, countsOffset;
+    dataStart = layout(false, bitsOffset, offsetsOffset, countsOffset);
+    bigTiff = dataStart + tiles * bytesPerTile > 0xFFFFFFFFull;
+    if (bigTiff)
+        dataStart = layout(true, bitsOffset, offsetsOffset, countsOffset);
+
+    const uint64_t fileSize = dataStart + tiles * bytesPerTile;
+
+    file = fopen(path.c_str(), keepTiles ? "r+b" : "wb");
+    if (!file)
+    {
+        if (!keepTiles)
+            std::cout << "Failed to open \"" << path << "\" for writing!" << std::endl;
+        return false;
+    }
+
+    // anything else isn't the image being resumed
+    if (keepTiles && fileLength(file) != fileSize)
+    {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    const int fieldSize = bigTiff ? 8 : 4;
+    const uint16_t offsetType = bigTiff ? TYPE_LONG8 : TYPE_LONG;
+
+    ByteWriter out;
+    out.put('I', 1);
+    out.put('I', 1);
+    if (bigTiff)
+    {
+        out.put(43, 2);
+        out.put(8, 2); // offset size
+        out.put(0, 2);
+        out.put(16, 8); // first IFD
+        out.put(ENTRY_COUNT, 8);
+    }
+    else
+    {
+        out.put(42, 2);
+        out.put(8, 4);
+        out.put(ENTRY_COUNT, 2);
+    }
+
+    // in ascending tag order, values that fit are stored right in the entry
+    const auto entry = [&](const uint16_t tag, const uint16_t type, const uint64_t count, const uint64_t value) {
+        out.put(tag, 2);
+        out.put(type, 2);
+        out.put(count, fieldSize);
+        out.put(value, fieldSize);
+    };
+
+    entry(256, TYPE_LONG, 1, uint64_t(imageSize.x)); // ImageWidth
+    entry(257, TYPE_LONG, 1, uint64_t(imageSize.y)); // ImageLength
+    entry(258, TYPE_SHORT, 3, bitsOffset ? bitsOffset : 8 | 8 << 16 | uint64_t(8) << 32); // BitsPerSample
+    entry(259, TYPE_SHORT, 1, 1); // Compression: none
+    entry(262, TYPE_SHORT, 1, 2); // PhotometricInterpretation: RGB
+    entry(277, TYPE_SHORT, 1, 3); // SamplesPerPixel
+    entry(284, TYPE_SHORT, 1, 1); // PlanarConfiguration: RGBRGB
+    entry(322, TYPE_LONG, 1, uint64_t(tileSize)); // TileWidth
+    entry(323, TYPE_LONG, 1, uint64_t(tileSize)); // TileLength
+    entry(324, offsetType, tiles, offsetsOffset ? offsetsOffset : dataStart); // TileOffsets
+    entry(325, offsetType, tiles, countsOffset ? countsOffset : bytesPerTile); // TileByteCounts
+    out.put(0, fieldSize); // no next IFD
+
+    if (bitsOffset)
+    {
+        for (int i = 0; i < 3; i++)
+            out.put(8, 2);
+    }
+
+    bool ok = fwrite(out.bytes.data(), 1, out.bytes.size(), file) == out.bytes.size();
+
+    // a row of tiles at a time, there can be a lot of them
+    const auto putArray = [&](const uint64_t arrayOffset, const bool offsets) {
+        if (!arrayOffset)
+            return;
+
+        ok &= seek(file, arrayOffset);
+        for (int y = 0; y < tileCount.y; y++)
+        {
+            ByteWriter row;
+            for (int x = 0; x < tileCount.x; x++)
+                row.put(offsets ? tileOffset(x, y) : bytesPerTile, fieldSize);
+            ok &= fwrite(row.bytes.data(), 1, row.bytes.size(), file) == row.bytes.size();
+        }
+    };
+    putArray(offsetsOffset, true);
+    putArray(countsOffset, false);
+
+    // the full size right away, sparse where the file system can
+    if (!keepTiles)
+    {
+        const uint8_t last = 0;
+        ok &= seek(file, fileSize - 1);
+        ok &= fwrite(&last, 1, 1, file) == 1;
+    }
+
+    if (!ok)
+    {
+        std::cout << "Failed to write the TIFF header to \"" << path << "\"!" << std::endl;
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    tileBytes.resize(size_t(bytesPerTile));
+    return true;
+}
+
+bool TiledTiff::writeTile(const int x, const int y, const std::vector<glm::vec3>& pixels)
+{
+    if (!file || x < 0 || y < 0 || x >= tileCount.x || y >= tileCount.y || pixels.size() < size_t(tileSize) * tileSize)
+        return false;
+
+    for (size_t i = 0; i < size_t(tileSize) * tileSize; i++)
+    {
+        const glm::vec3 color = glm::clamp(pixels[i], 0.f, 1.f);
+
+        tileBytes[i * 3 + 0] = (unsigned char)(color.r * 255.f + 0.5f);
+        tileBytes[i * 3 + 1] = (unsigned char)(color.g * 255.f + 0.5f);
+        tileBytes[i * 3 + 2] = (unsigned char)(color.b * 255.f + 0.5f);
+    }
+
+    return seek(file, tileOffset(x, y)) && fwrite(tileBytes.data(), 1, tileBytes.size(), file) == tileBytes.size();
+}
+
+bool TiledTiff::sync()
+{
+    return file && syncFile(file);
+}
+
+bool TiledTiff::close()
+{
+    if (!file)
+        return true;
+
+    const bool ok = fflush(file) == 0 && !ferror(file);
+    fclose(file);
+    file = nullptr;
+
+    std::vector<uint8_t>().swap(tileBytes);
+    return ok;
+}
+
+glm::ivec2 TiledTiff::getTileCount() const
+{
+    return tileCount;
+}
+
+bool TiledTiff::isBigTiff() const
+{
+    return bigTiff;
+}
+
+uint64_t TiledTiff::tileOffset(const int x, const int y) const
+{
+    // left to right, then top to bottom, like TIFF numbers them
+    const uint64_t index = uint64_t(y) * uint64_t(tileCount.x) + uint64_t(x);
+    return dataStart + index * uint64_t(tileSize) * uint64_t(tileSize) * 3;
+}
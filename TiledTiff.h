@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// An uncompressed 8 bit RGB TIFF cut into square tiles, for images far too big to
+// keep in memory. Every tile has a fixed spot in the file, so the header and tile
+// tables are written up front by open() and tiles can then be written in any order
+// with only one of them in memory at a time. Files over 4GB are BigTIFF.
+class TiledTiff
+{
+public:
+    TiledTiff() = default;
+    ~TiledTiff();
+
+    TiledTiff(const TiledTiff&) = delete;
+    TiledTiff& operator=(const TiledTiff&) = delete;
+
+    // tileSize must be a multiple of 16, as TIFF wants. keepTiles reopens a file open()
+    // made with the same sizes without touching the tiles already in it
+    bool open(const std::string& path, glm::ivec2 imageSize, int tileSize, bool keepTiles = false);
+
+    // writes tile (x, y) from tileSize x tileSize pixels, whatever of them falls
+    // outside the image included
+    bool writeTile(int x, int y, const std::vector<glm::vec3>& pixels);
+
+    // waits until the tiles written so far are on the disk
+    bool sync();
+
+    // false if anything failed to reach the disk
+    bool close();
+
+    glm::ivec2 getTileCount() const;
+    bool isBigTiff() const;
+
+private:
+    // where tile (x, y)'s pixels go
+    uint64_t tileOffset(int x, int y) const;
+
+    FILE* file = nullptr;
+    glm::ivec2 imageSize{ 0 };
+    glm::ivec2 tileCount{ 0 };
+    int tileSize = 0;
+    bool bigTiff = false;
+    uint64_t dataStart = 0;
+
+    std::vector<uint8_t> tileBytes;
+};
@@ -0,0 +1,114 @@
+#include "UniformRing.h"
+
+#include <cstring>
+
+// from GL 4.4 / GL_ARB_buffer_storage, which our glad doesn't have
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+namespace
+{
+    bool hasBufferStorage()
+    {
+        if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4))
+            return true;
+
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+            if (extension && strcmp(extension, "GL_ARB_buffer_storage") == 0)
+                return true;
+        }
+        return false;
+    }
+}
+
+void UniformRing::init(const GLsizeiptr blockSize, const GLADloadproc loader)
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    size = blockSize;
+    regionSize = (blockSize + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+    const auto bufferStorage = hasBufferStorage()
+        ? reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(loader("glBufferStorage")) : nullptr;
+
+    if (bufferStorage)
+    {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_UNIFORM_BUFFER, regionSize * REGIONS, nullptr, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, regionSize * REGIONS, flags));
+    }
+
+    if (!mapped)
+        glBufferData(GL_UNIFORM_BUFFER, regionSize * REGIONS, nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformRing::destroy()
+{
+    for (GLsync& sync : fences)
+    {
+        if (sync)
+            glDeleteSync(sync);
+        sync = nullptr;
+    }
+
+    if (mapped)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        mapped = nullptr;
+    }
+
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
+
+void UniformRing::write(const void* data, const GLuint binding)
+{
+    region = (region + 1) % REGIONS;
+    const GLintptr offset = region * regionSize;
+
+    if (mapped)
+    {
+        // only waits if the GPU is a whole ring behind
+        GLsync& sync = fences[region];
+        if (sync)
+        {
+            glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+            glDeleteSync(sync);
+            sync = nullptr;
+        }
+
+        memcpy(mapped + offset, data, size_t(size));
+    }
+    else
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+}
+
+void UniformRing::fence()
+{
+    if (mapped)
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool UniformRing::isPersistent() const
+{
+    return mapped != nullptr;
+}
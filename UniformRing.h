@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// A uniform buffer with REGIONS copies of the same block, so the CPU can fill
+// one while the GPU may still be reading the others. With buffer storage (core
+// in 4.4, GL_ARB_buffer_storage before that) the buffer stays persistently
+// mapped and each write is a memcpy, guarded by a fence per region. Without
+// it each write is one glBufferSubData.
+class UniformRing
+{
+public:
+    static constexpr int REGIONS = 3;
+
+    UniformRing() = default;
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    // needs a current OpenGL context, loader is for the functions our glad doesn't have
+    void init(GLsizeiptr blockSize, GLADloadproc loader);
+
+    // the destructor leaves the buffer alone, since the context might be gone by then
+    void destroy();
+
+    // copies blockSize bytes into the next region and binds it to the uniform block binding
+    void write(const void* data, GLuint binding);
+
+    // call after the last dispatch that reads what write() bound
+    void fence();
+
+    bool isPersistent() const;
+
+private:
+    GLuint buffer = 0;
+    GLsizeiptr size = 0;
+    GLsizeiptr regionSize = 0; // size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    int region = 0;
+
+    unsigned char* mapped = nullptr;
+    GLsync fences[REGIONS] = {};
+};
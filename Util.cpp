@@ -1,11 +1,20 @@
 #include "Util.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <complex>
+#include <cstdio>
 #include <iostream>
 #include <glm/geometric.hpp>
 #include <glm/trigonometric.hpp>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 float currentTime()
 {
     static bool firstCall = true;
@@ -237,6 +246,44 @@ glm::vec3 rotToVec3(const float yaw, const float pitch)
     return glm::normalize(ret);
 }
 
+float percentile(const std::vector<float>& sorted, const float p)
+{
+    const size_t rank = size_t(std::ceil(p / 100.f * float(sorted.size())));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+bool writePPM(const std::string& path, const int width, const int height, const std::vector<glm::vec3>& pixels)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "Failed to open \"" << path << "\" for writing!" << std::endl;
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+    std::vector<unsigned char> row(size_t(width) * 3);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const glm::vec3 color = glm::clamp(pixels[size_t(y) * width + x], 0.f, 1.f);
+
+            row[x * 3 + 0] = (unsigned char)(color.r * 255.f + 0.5f);
+            row[x * 3 + 1] = (unsigned char)(color.g * 255.f + 0.5f);
+            row[x * 3 + 2] = (unsigned char)(color.b * 255.f + 0.5f);
+        }
+
+        fwrite(row.data(), 1, row.size(), file);
+    }
+
+    const bool success = !ferror(file);
+    fclose(file);
+
+    return success;
+}
+
 glm::vec3 operator*(const glm::vec3& left, const bool& right)
 {
     if (right)
@@ -248,4 +295,28 @@ glm::vec3 operator*(const glm::vec3& left, const bool& right)
 glm::vec3 operator*(const bool& left, const glm::vec3& right)
 {
     return right * left;
-}
\ No newline at end of file
+}
+
+std::string frameFileName(const std::string& output, const int frame)
+{
+    char number[16];
+    snprintf(number, sizeof(number), "_%04d", frame);
+
+    const size_t dot = output.find_last_of('.');
+    if (dot == std::string::npos || output.find_first_of("/\\", dot) != std::string::npos)
+        return output + number;
+
+    return output.substr(0, dot) + number + output.substr(dot);
+}
+
+bool syncFile(FILE* file)
+{
+    if (fflush(file) != 0)
+        return false;
+
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
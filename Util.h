@@ -1,7 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
@@ -71,5 +74,17 @@ std::ostream& operator<<(std::ostream& os, const glm::vec3& vec3);
 
 glm::vec3 rotToVec3(float yaw, float pitch);
 
+// nearest-rank percentile of sorted values, p in [0, 100]
+float percentile(const std::vector<float>& sorted, float p);
+
+// writes a binary PPM, colors are clamped to [0, 1]
+bool writePPM(const std::string& path, int width, int height, const std::vector<glm::vec3>& pixels);
+
+// "fractal.ppm" -> "fractal_0001.ppm", for writing more than one frame
+std::string frameFileName(const std::string& output, int frame);
+
+// flushes file and waits until it's actually on the disk
+bool syncFile(FILE* file);
+
 glm::vec3 operator*(const glm::vec3& left, const bool& right);
 glm::vec3 operator*(const bool& left, const glm::vec3& right);
\ No newline at end of file
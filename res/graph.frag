@@ -0,0 +1,46 @@
+#version 330 core
+
+in vec2 texCoord;
+
+out vec4 fragColor;
+
+// FrameTimer::getGraph(), one column per frame with the CPU stages in the first rows and the GPU stages after
+uniform sampler2D timings;
+
+// milliseconds at the top of each half
+uniform float msScale;
+
+#define STAGE_COUNT 5
+
+// update, raytrace, capture, screen, swap
+const vec3 STAGE_COLORS[STAGE_COUNT] = vec3[](
+    vec3(0.6, 0.6, 0.6),
+    vec3(0.95, 0.45, 0.2),
+    vec3(0.85, 0.3, 0.75),
+    vec3(0.3, 0.7, 0.95),
+    vec3(0.5, 0.85, 0.35)
+);
+
+void main() {
+    // CPU on top, GPU below, each stacked from the bottom of its half
+    float up = 1.0 - texCoord.y;
+    int firstRow = up < 0.5 ? STAGE_COUNT : 0;
+    float ms = fract(up * 2.0) * msScale;
+
+    int x = int(texCoord.x * float(textureSize(timings, 0).x));
+
+    fragColor = vec4(0.0, 0.0, 0.0, 0.5);
+
+    float total = 0.0;
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        total += texelFetch(timings, ivec2(x, firstRow + i), 0).r;
+        if (ms < total) {
+            fragColor = vec4(STAGE_COLORS[i], 0.9);
+            break;
+        }
+    }
+
+    // 60 fps line
+    if (abs(ms - 16.666) < fwidth(ms))
+        fragColor = vec4(1.0);
+}
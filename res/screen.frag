@@ -2,8 +2,70 @@
 
 in vec2 texCoord;
 
-uniform sampler2D tex;
+out vec4 fragColor;
+
+// the G-buffer res/raytrace.comp fills, see initGBuffer()
+uniform usampler2D steps; // marching steps in 1/stepScale
+uniform sampler2D trap; // DE's orbit trap where the ray reached the surface, and the fraction of samples that did
+uniform sampler2D hitDistance; // how far the ray went where it reached the surface
+
+uniform float stepScale;
+uniform vec2 usedSize; // texels from the corner of the G-buffer the raytracer filled this frame
+uniform vec3 color;
+uniform int palette; // Palette in Fractal4D.cpp
+uniform bool readBack; // rows in the order raytrace.comp wrote them, for reading back instead of showing
+
+#define PALETTE_STEPS 0
+#define PALETTE_TRAP 1
+#define PALETTE_FOG 2
+
+// thanks, http://lolengine.net/blog/2013/07/27/rgb-to-hsv-in-glsl
+vec3 hsv2rgb(vec3 c)
+{
+    vec4 K = vec4(1.0, 2.0 / 3.0, 1.0 / 3.0, 3.0);
+    vec3 p = abs(fract(c.xxx + K.xyz) * 6.0 - K.www);
+    return c.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);
+}
+
+vec3 shade(ivec2 texel)
+{
+    float stepCount = float(texelFetch(steps, texel, 0).x) / stepScale;
+    vec3 glow = color * (stepCount / 40.f);
+
+    if (palette == PALETTE_TRAP) {
+        // the surface gets a hue from how close its orbit came to the origin, misses keep the glow
+        vec2 orbit = texelFetch(trap, texel, 0).xy;
+        vec3 hue = hsv2rgb(vec3(fract(0.45 + 0.9 * orbit.x), 0.65, 1.0)) * (stepCount / 40.f);
+        return mix(glow, hue, orbit.y);
+    }
+
+    // rays that flew off are lost in the fog
+    if (palette == PALETTE_FOG) {
+        float distance = texelFetch(hitDistance, texel, 0).x;
+        float surface = texelFetch(trap, texel, 0).y;
+        return glow * exp(-0.5 * distance) * surface;
+    }
+
+    return glow;
+}
 
 void main() {
-    gl_FragColor = texture(tex, texCoord);
-}
\ No newline at end of file
+    vec2 texel = texCoord * usedSize;
+    if (readBack)
+        texel.y = usedSize.y - texel.y;
+
+    // A screen pixel that covers more than one texel blends the four around it. Integer
+    // textures can't be filtered, and shading before blending keeps every palette exact
+    if (any(greaterThan(fwidth(texel), vec2(1.0)))) {
+        vec2 corner = clamp(texel - 0.5, vec2(0.0), usedSize - 1.0);
+        ivec2 low = ivec2(corner);
+        ivec2 high = min(low + 1, ivec2(usedSize) - 1);
+        vec2 f = corner - vec2(low);
+
+        vec3 bottom = mix(shade(low), shade(ivec2(high.x, low.y)), f.x);
+        vec3 top = mix(shade(ivec2(low.x, high.y)), shade(high), f.x);
+        fragColor = vec4(mix(bottom, top, f.y), 1.0);
+    }
+    else
+        fragColor = vec4(shade(ivec2(min(texel, usedSize - 1.0))), 1.0);
+}